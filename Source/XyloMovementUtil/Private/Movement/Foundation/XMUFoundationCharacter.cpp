@@ -6,6 +6,7 @@
 #include "InputActionValue.h"
 #include "Movement/Foundation/XMUFoundationMovement.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 AXMUFoundationCharacter::AXMUFoundationCharacter(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer.SetDefaultSubobjectClass<UXMUFoundationMovement>(ACharacter::CharacterMovementComponentName))
@@ -25,25 +26,10 @@ void AXMUFoundationCharacter::GetLifetimeReplicatedProps(TArray<FLifetimePropert
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME_CONDITION(ThisClass, ReplicatedAcceleration, COND_SimulatedOnly);
-}
-
-void AXMUFoundationCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
-{
-	Super::PreReplication(ChangedPropertyTracker);
-
-	if (UCharacterMovementComponent* MovementComponent = GetCharacterMovement())
-	{
-		// Compress Acceleration: XY components as direction + magnitude, Z component as direct value
-		const double MaxAccel = MovementComponent->MaxAcceleration;
-		const FVector CurrentAccel = MovementComponent->GetCurrentAcceleration();
-		double AccelXYRadians, AccelXYMagnitude;
-		FMath::CartesianToPolar(CurrentAccel.X, CurrentAccel.Y, AccelXYMagnitude, AccelXYRadians);
-
-		ReplicatedAcceleration.AccelXYRadians   = FMath::FloorToInt((AccelXYRadians / TWO_PI) * 255.0);     // [0, 2PI] -> [0, 255]
-		ReplicatedAcceleration.AccelXYMagnitude = FMath::FloorToInt((AccelXYMagnitude / MaxAccel) * 255.0);	// [0, MaxAccel] -> [0, 255]
-		ReplicatedAcceleration.AccelZ           = FMath::FloorToInt((CurrentAccel.Z / MaxAccel) * 127.0);   // [-MaxAccel, MaxAccel] -> [-127, 127]
-	}
+	FDoRepLifetimeParams AccelerationParams;
+	AccelerationParams.bIsPushBased = true;
+	AccelerationParams.Condition = COND_SimulatedOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, ReplicatedAcceleration, AccelerationParams);
 }
 
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -211,20 +197,33 @@ float AXMUFoundationCharacter::GetGroundDistance()
 	return 0.f;
 }
 
+void AXMUFoundationCharacter::UpdateReplicatedAcceleration(const FVector& Acceleration, double MaxAcceleration, float MinSendInterval)
+{
+	// Compress Acceleration: XY components as direction + magnitude, Z component as direct value
+	FXMUReplicatedAcceleration NewReplicatedAcceleration;
+	NewReplicatedAcceleration.Pack(Acceleration, MaxAcceleration);
+
+	if (NewReplicatedAcceleration != ReplicatedAcceleration)
+	{
+		// Held back changes are picked up by the first call after the interval, which packs the latest acceleration
+		const double Time = GetWorld()->GetTimeSeconds();
+		if (Time - LastReplicatedAccelerationChangeTime < MinSendInterval)
+		{
+			return;
+		}
+		LastReplicatedAccelerationChangeTime = Time;
+		
+		ReplicatedAcceleration = NewReplicatedAcceleration;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ReplicatedAcceleration, this);
+	}
+}
+
 void AXMUFoundationCharacter::OnRep_ReplicatedAcceleration()
 {
 	if (UXMUFoundationMovement* XMUMovementComponent = Cast<UXMUFoundationMovement>(GetCharacterMovement()))
 	{
 		// Decompress Acceleration
-		const double MaxAccel         = XMUMovementComponent->MaxAcceleration;
-		const double AccelXYMagnitude = double(ReplicatedAcceleration.AccelXYMagnitude) * MaxAccel / 255.0; // [0, 255] -> [0, MaxAccel]
-		const double AccelXYRadians   = double(ReplicatedAcceleration.AccelXYRadians) * TWO_PI / 255.0;     // [0, 255] -> [0, 2PI]
-
-		FVector UnpackedAcceleration(FVector::ZeroVector);
-		FMath::PolarToCartesian(AccelXYMagnitude, AccelXYRadians, UnpackedAcceleration.X, UnpackedAcceleration.Y);
-		UnpackedAcceleration.Z = double(ReplicatedAcceleration.AccelZ) * MaxAccel / 127.0; // [-127, 127] -> [-MaxAccel, MaxAccel]
-
-		XMUMovementComponent->SetReplicatedAcceleration(UnpackedAcceleration);
+		XMUMovementComponent->SetReplicatedAcceleration(ReplicatedAcceleration.Unpack(XMUMovementComponent->MaxAcceleration));
 	}
 }
 
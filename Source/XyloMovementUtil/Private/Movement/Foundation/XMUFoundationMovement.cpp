@@ -4,8 +4,13 @@
 #include "Movement/Foundation/XMUFoundationMovement.h"
 
 #include "Components/CapsuleComponent.h"
+#include "Engine/OverlapResult.h"
+#include "Camera/PlayerCameraManager.h"
 #include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
 #include "Movement/Foundation/XMUFoundationCharacter.h"
+#include "Movement/Foundation/XMUFoundationStats.h"
+#include "Movement/Foundation/XMUGroundQuerySubsystem.h"
 
 // Helper Macros
 #if 0
@@ -32,6 +37,66 @@ float MacroDuration = 2.f;
 
 DEFINE_LOG_CATEGORY_STATIC(LogCharacterMovement, Log, All);
 
+CSV_DEFINE_CATEGORY(XMUMovement, true);
+
+// Move combining telemetry (client side)
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combine Accepted"), STAT_XMUCombineAccepted, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combine Rejected: Stamina Drained"), STAT_XMUCombineRejectedStaminaDrained, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combine Rejected: Charge Drained"), STAT_XMUCombineRejectedChargeDrained, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combine Rejected: Coyote Time"), STAT_XMUCombineRejectedCoyoteTime, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combine Rejected: Anim Root Motion"), STAT_XMUCombineRejectedAnimRootMotion, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combine Rejected: Root Motion Source"), STAT_XMUCombineRejectedRootMotionSource, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combine Rejected: Crouch Transition"), STAT_XMUCombineRejectedCrouchTransition, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combine Rejected: Compressed Flags"), STAT_XMUCombineRejectedCompressedFlags, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Combine Rejected: Engine"), STAT_XMUCombineRejectedEngine, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Important Move: Compressed Flags"), STAT_XMUImportantMoveCompressedFlags, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Important Move: Engine"), STAT_XMUImportantMoveEngine, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Force No Combine: Stamina Drained"), STAT_XMUForceNoCombineStaminaDrained, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Force No Combine: Charge Drained"), STAT_XMUForceNoCombineChargeDrained, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Force No Combine: Crouch Transition"), STAT_XMUForceNoCombineCrouchTransition, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("ServerMove RPCs"), STAT_XMUServerMoveRPC, STATGROUP_XMUMovement);
+
+// Client correction telemetry (server side), see also XMU.DumpCorrectionStats
+DECLARE_DWORD_COUNTER_STAT(TEXT("Correction: Position"), STAT_XMUCorrectionPosition, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Correction: Stamina"), STAT_XMUCorrectionStamina, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Correction: Charge"), STAT_XMUCorrectionCharge, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Correction: Coyote Time"), STAT_XMUCorrectionCoyoteTime, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Correction: Resource Checksum"), STAT_XMUCorrectionResourceChecksum, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Correction: Resource Only"), STAT_XMUCorrectionResourceOnly, STATGROUP_XMUMovement);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Encroachment Memo: Hit"), STAT_XMUEncroachmentMemoHit, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Encroachment Memo: Recorded"), STAT_XMUEncroachmentMemoRecorded, STATGROUP_XMUMovement);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Idle Sleep: Sleeping"), STAT_XMUIdleSleeping, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Idle Sleep: Enter"), STAT_XMUIdleSleepEnter, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Idle Sleep: Wake"), STAT_XMUIdleSleepWake, STATGROUP_XMUMovement);
+
+DECLARE_CYCLE_STAT(TEXT("Replay"), STAT_XMUReplay, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replays"), STAT_XMUReplayCount, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replayed Moves"), STAT_XMUReplayedMoves, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replay Query Cache: Hit"), STAT_XMUReplayQueryCacheHit, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Replay Query Cache: Miss"), STAT_XMUReplayQueryCacheMiss, STATGROUP_XMUMovement);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Last Replay Time (ms)"), STAT_XMUReplayTimeMs, STATGROUP_XMUMovement);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Headroom: Sweep"), STAT_XMUHeadroomSweep, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Headroom: Rejected Resize"), STAT_XMUHeadroomRejected, STATGROUP_XMUMovement);
+
+DECLARE_CYCLE_STAT(TEXT("Ground Trace"), STAT_XMUGroundTrace, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ground Traces"), STAT_XMUGroundTraceCount, STATGROUP_XMUMovement);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Ground Trace Length"), STAT_XMUGroundTraceLength, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ground Info: Predicted"), STAT_XMUGroundInfoPredicted, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ground Info: Prediction Retrace"), STAT_XMUGroundInfoPredictionRetrace, STATGROUP_XMUMovement);
+
+DECLARE_CYCLE_STAT(TEXT("Simulated Tick"), STAT_XMUSimulatedTick, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sim Proxy LOD: Full"), STAT_XMUSimulatedProxyLODFull, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sim Proxy LOD: Reduced"), STAT_XMUSimulatedProxyLODReduced, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sim Proxy LOD: Far"), STAT_XMUSimulatedProxyLODFar, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sim Proxy LOD: Skipped Tick"), STAT_XMUSimulatedProxySkippedTick, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sim Proxy LOD: Skipped Floor Check"), STAT_XMUSimulatedProxySkippedFloorCheck, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sim Proxy: Collision Disabled"), STAT_XMUSimulatedProxyCollisionDisabled, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sim Proxy: Frozen Capsule Resize"), STAT_XMUSimulatedProxyFrozenCapsuleResize, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sim Proxy: Capsule Thaw"), STAT_XMUSimulatedProxyCapsuleThaw, STATGROUP_XMUMovement);
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /*
  * Move Response Data
@@ -62,12 +127,14 @@ bool FXMUFoundationMoveResponseDataContainer::Serialize(UCharacterMovementCompon
 
 	if (IsCorrection())
 	{
-		Ar << Stamina;
+		const UXMUFoundationMovement& MoveComp = static_cast<const UXMUFoundationMovement&>(CharacterMovement);
+		
+		MoveComp.GetNetworkStaminaQuantization().SerializeOptional(Ar, Stamina);
 		Ar << bStaminaDrained;
-		Ar << Charge;
+		MoveComp.GetNetworkChargeQuantization().SerializeOptional(Ar, Charge);
 		Ar << bChargeDrained;
 		
-		Ar << CoyoteTimeDuration;
+		MoveComp.GetNetworkCoyoteTimeDurationQuantization().SerializeOptional(Ar, CoyoteTimeDuration);
 	}
 
 	return !Ar.IsError();
@@ -82,7 +149,8 @@ void FXMUFoundationNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_C
 {
 	Super::ClientFillNetworkMoveData(ClientMove, MoveType);
 
-	const FXMUSavedMove_Character_Foundation FoundationClientMove = static_cast<const FXMUSavedMove_Character_Foundation&>(ClientMove);
+	// Read by reference: this runs for up to three moves per send and must not copy the saved move
+	const FXMUSavedMove_Character_Foundation& FoundationClientMove = static_cast<const FXMUSavedMove_Character_Foundation&>(ClientMove);
 	
 	FoundationCompressedMoveFlags = FoundationClientMove.GetFoundationCompressedFlags();
 	
@@ -95,14 +163,73 @@ void FXMUFoundationNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_C
 bool FXMUFoundationNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar,
 	UPackageMap* PackageMap, ENetworkMoveType MoveType)
 {
-	Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+	if (!Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType))
+	{
+		return false;
+	}
     
-	SerializeOptionalValue<uint8>(Ar.IsSaving(), Ar, FoundationCompressedMoveFlags, 0);
-	
-	SerializeOptionalValue<float>(Ar.IsSaving(), Ar, Stamina, 0.f);
-	SerializeOptionalValue<float>(Ar.IsSaving(), Ar, Charge, 0.f);
+	const UXMUFoundationMovement& MoveComp = static_cast<const UXMUFoundationMovement&>(CharacterMovement);
+
+	// Pending and Old moves are usually a few ticks away from the New one, so we send them as differences from it
+	const FXMUFoundationNetworkMoveData* DeltaBase = MoveType != ENetworkMoveType::NewMove ? DeltaBaseMoveData : nullptr;
+
+	if (DeltaBase)
+	{
+		uint8 bSameFlags = Ar.IsSaving() ? FoundationCompressedMoveFlags == DeltaBase->FoundationCompressedMoveFlags : 0;
+		Ar.SerializeBits(&bSameFlags, 1);
+		if (bSameFlags)
+		{
+			FoundationCompressedMoveFlags = DeltaBase->FoundationCompressedMoveFlags;
+		}
+		else
+		{
+			SerializeOptionalValue<uint8>(Ar.IsSaving(), Ar, FoundationCompressedMoveFlags, 0);
+		}
+	}
+	else
+	{
+		SerializeOptionalValue<uint8>(Ar.IsSaving(), Ar, FoundationCompressedMoveFlags, 0);
+	}
+
+	if (MoveComp.UsesNetworkResourceChecksum())
+	{
+		// The server can derive the resources on its own, so we only send a checksum of what we predicted
+		const uint8 ChecksumBits = MoveComp.GetNetworkResourceChecksumBits();
+		if (Ar.IsSaving())
+		{
+			ResourceChecksum = MoveComp.GetNetworkResourceChecksum(Stamina, Charge, CoyoteTimeDuration);
+		}
+
+		uint8 bSameChecksum = (DeltaBase && Ar.IsSaving()) ? ResourceChecksum == DeltaBase->ResourceChecksum : 0;
+		if (DeltaBase)
+		{
+			Ar.SerializeBits(&bSameChecksum, 1);
+		}
+		if (bSameChecksum)
+		{
+			ResourceChecksum = DeltaBase->ResourceChecksum;
+		}
+		else
+		{
+			Ar.SerializeInt(ResourceChecksum, 1u << ChecksumBits);
+		}
+	}
+	else if (DeltaBase)
+	{
+		const uint8 DeltaBits = MoveComp.GetNetworkResourceDeltaBits();
+		MoveComp.GetNetworkStaminaQuantization().SerializeDelta(Ar, Stamina, DeltaBase->Stamina, DeltaBits);
+		MoveComp.GetNetworkChargeQuantization().SerializeDelta(Ar, Charge, DeltaBase->Charge, DeltaBits);
 
-	SerializeOptionalValue<float>(Ar.IsSaving(), Ar, CoyoteTimeDuration, 0.f);
+		MoveComp.GetNetworkCoyoteTimeDurationQuantization().SerializeDelta(Ar, CoyoteTimeDuration, DeltaBase->CoyoteTimeDuration, DeltaBits);
+	}
+	else
+	{
+		// Resources are quantized using their max value as range (8-12 bits each instead of 32)
+		MoveComp.GetNetworkStaminaQuantization().SerializeOptional(Ar, Stamina);
+		MoveComp.GetNetworkChargeQuantization().SerializeOptional(Ar, Charge);
+
+		MoveComp.GetNetworkCoyoteTimeDurationQuantization().SerializeOptional(Ar, CoyoteTimeDuration);
+	}
 	
 	return !Ar.IsError();
 }
@@ -112,6 +239,12 @@ bool FXMUFoundationNetworkMoveData::Serialize(UCharacterMovementComponent& Chara
  * Saved Move
  */
 
+namespace XMUFoundationCharacter
+{
+	static int32 RelaxedMoveCombining = 1;
+	FAutoConsoleVariableRef CVar_RelaxedMoveCombining(TEXT("XMU.RelaxedMoveCombining"), RelaxedMoveCombining, TEXT("If non zero, moves can be combined across uncrouch transition ends and coyote time running out when not jumping."), ECVF_Default);
+}
+
 void FXMUSavedMove_Character_Foundation::Clear()
 {
 	Super::Clear();
@@ -129,67 +262,97 @@ void FXMUSavedMove_Character_Foundation::Clear()
 	CrouchProgress = 0.f;
 	bCrouchTransitioning = false;
 
-	AnimRootMotionTransitionName = "";
+	AnimRootMotionTransitionName.Reset();
 	bAnimRootMotionTransitionFinishedLastFrame = false;
-	RootMotionSourceTransitionName = "";
+	RootMotionSourceTransitionName.Reset();
 	bRootMotionSourceTransitionFinishedLastFrame = false;
 }
 
 bool FXMUSavedMove_Character_Foundation::IsImportantMove(const FSavedMovePtr& LastAckedMove) const
 {
-	const TSharedPtr<FXMUSavedMove_Character_Foundation>& LastFoundationAckedMove = StaticCastSharedPtr<FXMUSavedMove_Character_Foundation>(LastAckedMove);
+	const FXMUSavedMove_Character_Foundation* LastFoundationAckedMove = static_cast<const FXMUSavedMove_Character_Foundation*>(LastAckedMove.Get());
 	
 	// Check if any important movement flags have changed status.
 	if (GetFoundationCompressedFlags() != LastFoundationAckedMove->GetFoundationCompressedFlags())
 	{
+		XMU_COUNT_STAT(ImportantMoveCompressedFlags);
 		return true;
 	}
 	
-	return FSavedMove_Character::IsImportantMove(LastAckedMove);
+	if (FSavedMove_Character::IsImportantMove(LastAckedMove))
+	{
+		XMU_COUNT_STAT(ImportantMoveEngine);
+		return true;
+	}
+	return false;
 }
 
 bool FXMUSavedMove_Character_Foundation::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
 {
-	const TSharedPtr<FXMUSavedMove_Character_Foundation>& NewFoundationMove = StaticCastSharedPtr<FXMUSavedMove_Character_Foundation>(NewMove);
+	const FXMUSavedMove_Character_Foundation* NewFoundationMove = static_cast<const FXMUSavedMove_Character_Foundation*>(NewMove.Get());
 
 	if (bStaminaDrained != NewFoundationMove->bStaminaDrained)
 	{
+		XMU_COUNT_STAT(CombineRejectedStaminaDrained);
 		return false;
 	}
 
 	if (bChargeDrained != NewFoundationMove->bChargeDrained)
 	{
+		XMU_COUNT_STAT(CombineRejectedChargeDrained);
 		return false;
 	}
 
-	// TODO: find out if this is even needed
+	// Coyote time decays deterministically and the combined move is simulated again from the start of this one, so
+	// running out of it only matters if a jump has to be validated against it
 	if ((StartCoyoteTimeDuration == 0.f) != (NewFoundationMove->StartCoyoteTimeDuration == 0.f))
 	{
-		return false;
+		if (!XMUFoundationCharacter::RelaxedMoveCombining || bPressedJump || NewFoundationMove->bPressedJump)
+		{
+			XMU_COUNT_STAT(CombineRejectedCoyoteTime);
+			return false;
+		}
 	}
 
 	if (bAnimRootMotionTransitionFinishedLastFrame != NewFoundationMove->bAnimRootMotionTransitionFinishedLastFrame)
 	{
+		XMU_COUNT_STAT(CombineRejectedAnimRootMotion);
 		return false;
 	}
 
 	if (bRootMotionSourceTransitionFinishedLastFrame != NewFoundationMove->bRootMotionSourceTransitionFinishedLastFrame)
 	{
+		XMU_COUNT_STAT(CombineRejectedRootMotionSource);
 		return false;
 	}
 
+	// The end of an uncrouch transition only stops the crouch timer (the capsule was resized in BeginUnCrouch), so it
+	// is derived again from CrouchProgress when simulating the combined move. Any other change resizes the capsule.
 	if (bCrouchTransitioning != NewFoundationMove->bCrouchTransitioning)
 	{
-		return false;
+		const bool bFinishedUnCrouch = bCrouchTransitioning && InCharacter && !InCharacter->bIsCrouched;
+		if (!XMUFoundationCharacter::RelaxedMoveCombining || !bFinishedUnCrouch)
+		{
+			XMU_COUNT_STAT(CombineRejectedCrouchTransition);
+			return false;
+		}
 	}
 
 	// Compressed flags not equal, can't combine. This covers jump and crouch as well as any custom movement flags from overrides.
 	if (GetFoundationCompressedFlags() != NewFoundationMove->GetFoundationCompressedFlags())
 	{
+		XMU_COUNT_STAT(CombineRejectedCompressedFlags);
+		return false;
+	}
+
+	if (!Super::CanCombineWith(NewMove, InCharacter, MaxDelta))
+	{
+		XMU_COUNT_STAT(CombineRejectedEngine);
 		return false;
 	}
 
-	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+	XMU_COUNT_STAT(CombineAccepted);
+	return true;
 }
 
 void FXMUSavedMove_Character_Foundation::CombineWith(const FSavedMove_Character* OldMove, ACharacter* C,
@@ -208,6 +371,7 @@ void FXMUSavedMove_Character_Foundation::CombineWith(const FSavedMove_Character*
 
 		MoveComp->SetCoyoteTimeDuration(OldFoundationMove->StartCoyoteTimeDuration);
 
+		MoveComp->SetCrouchTransitioning(OldFoundationMove->bCrouchTransitioning);
 		MoveComp->SetCrouchProgress(OldFoundationMove->CrouchProgress);
 	}
 }
@@ -275,17 +439,25 @@ void FXMUSavedMove_Character_Foundation::PostUpdate(ACharacter* C, EPostUpdateMo
 		{
 			if (bStaminaDrained != MoveComp->IsStaminaDrained())
 			{
+				XMU_COUNT_STAT(ForceNoCombineStaminaDrained);
 				bForceNoCombine = true;
 			}
 
 			if (bChargeDrained != MoveComp->IsChargeDrained())
 			{
+				XMU_COUNT_STAT(ForceNoCombineChargeDrained);
 				bForceNoCombine = true;
 			}
 
+			// See CanCombineWith: finishing an uncrouch transition doesn't prevent combining
 			if (bCrouchTransitioning != MoveComp->IsCrouchTransitioning())
 			{
-				bForceNoCombine = true;
+				const bool bFinishedUnCrouch = bCrouchTransitioning && !MoveComp->IsCrouching();
+				if (!XMUFoundationCharacter::RelaxedMoveCombining || !bFinishedUnCrouch)
+				{
+					XMU_COUNT_STAT(ForceNoCombineCrouchTransition);
+					bForceNoCombine = true;
+				}
 			}
 		}
 	}
@@ -308,7 +480,25 @@ uint8 FXMUSavedMove_Character_Foundation::GetFoundationCompressedFlags() const
 namespace XMUFoundationCharacter
 {
 	static float GroundTraceDistance = 100000.0f;
-	FAutoConsoleVariableRef CVar_GroundTraceDistance(TEXT("LyraCharacter.GroundTraceDistance"), GroundTraceDistance, TEXT("Distance to trace down when generating ground information."), ECVF_Cheat);
+	FAutoConsoleVariableRef CVar_GroundTraceDistance(TEXT("LyraCharacter.GroundTraceDistance"), GroundTraceDistance, TEXT("Max distance to trace down when generating ground information."), ECVF_Cheat);
+
+	static float GroundTraceLookahead = 2.0f;
+	FAutoConsoleVariableRef CVar_GroundTraceLookahead(TEXT("XMU.GroundTraceLookahead"), GroundTraceLookahead, TEXT("Seconds of fall the ground trace covers (from the current vertical velocity and gravity). 0 always traces GroundTraceDistance."), ECVF_Default);
+
+	static float GroundTraceMinDistance = 500.0f;
+	FAutoConsoleVariableRef CVar_GroundTraceMinDistance(TEXT("XMU.GroundTraceMinDistance"), GroundTraceMinDistance, TEXT("Min distance to trace down when generating ground information."), ECVF_Default);
+
+	static float GroundInfoCacheMaxAge = 0.1f;
+	FAutoConsoleVariableRef CVar_GroundInfoCacheMaxAge(TEXT("XMU.GroundInfoCacheMaxAge"), GroundInfoCacheMaxAge, TEXT("Movement simulation seconds the ground info of a character that did not move stays valid (the ground itself may move)."), ECVF_Default);
+
+	static float GroundInfoCacheLocationTolerance = 0.01f;
+	FAutoConsoleVariableRef CVar_GroundInfoCacheLocationTolerance(TEXT("XMU.GroundInfoCacheLocationTolerance"), GroundInfoCacheLocationTolerance, TEXT("Distance the character can move before its cached ground info is invalidated."), ECVF_Default);
+
+	static int32 GroundInfoMaxAsyncAge = 2;
+	FAutoConsoleVariableRef CVar_GroundInfoMaxAsyncAge(TEXT("XMU.GroundInfoMaxAsyncAge"), GroundInfoMaxAsyncAge, TEXT("Max age (in frames) of an async ground trace result before GetGroundInfo falls back to a synchronous trace."), ECVF_Default);
+
+	static int32 ForceSimulatedProxyLOD = -1;
+	FAutoConsoleVariableRef CVar_ForceSimulatedProxyLOD(TEXT("XMU.ForceSimulatedProxyLOD"), ForceSimulatedProxyLOD, TEXT("If >= 0, simulated proxies with bEnableSimulatedProxyLOD use this LOD (0: Full, 1: Reduced, 2: Far) regardless of distance and visibility."), ECVF_Cheat);
 }
 
 
@@ -334,10 +524,18 @@ UXMUFoundationMovement::UXMUFoundationMovement(const FObjectInitializer& ObjectI
 	
 	NetworkStaminaCorrectionThreshold = 2.f;
 	NetworkChargeCorrectionThreshold = 2.f;
+	NetworkStaminaQuantizationBits = 10;
+	NetworkChargeQuantizationBits = 10;
 	SetMaxStamina(100.f);
 	SetMaxCharge(100.f);
 
 	NetworkCoyoteTimeDurationCorrectionThreshold = 0.1f;
+	NetworkCoyoteTimeDurationQuantizationBits = 8;
+	bUseNetworkResourceChecksum = false;
+	NetworkResourceChecksumBits = 12;
+	NetworkResourceDeltaBits = 6;
+	bUseResourceOnlyCorrections = true;
+	NetworkMinTimeBetweenResourceCorrections = 0.1f;
 	SetMaxCoyoteTimeDuration(0.4f);
 	SetCoyoteTimeFullDurationVelocity(1200.f);
 
@@ -374,6 +572,23 @@ void UXMUFoundationMovement::SetUpdatedComponent(USceneComponent* NewUpdatedComp
 
 void UXMUFoundationMovement::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
 {
+	ResourceRegenClock += DeltaSeconds;
+	
+	// Moves performed by MoveAutonomous (server moves and client replays) use their own time stamp, and locally
+	// predicted moves the one their saved move gets, so a replayed move lands exactly on the time it was first
+	// simulated at. The time goes back when a replay starts, see MovementSimulationTime
+	const FNetworkPredictionData_Client_Character* ClientData = CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_AutonomousProxy && !bClientUpdating && HasPredictionData_Client()
+		? GetPredictionData_Client_Character() : nullptr;
+	if (bHasAutonomousMoveTimeStamp)
+	{
+		MovementSimulationTime = AutonomousMoveTimeStamp;
+		bHasAutonomousMoveTimeStamp = false;
+	}
+	else
+	{
+		MovementSimulationTime = ClientData ? ClientData->CurrentTimeStamp : MovementSimulationTime + DeltaSeconds;
+	}
+	
 	UpdateStaminaBeforeMovement(DeltaSeconds);
 	UpdateChargeBeforeMovement(DeltaSeconds);
 	UpdateCoyoteTimeBeforeMovement(DeltaSeconds);
@@ -384,10 +599,10 @@ void UXMUFoundationMovement::UpdateCharacterStateBeforeMovement(float DeltaSecon
 	
 	if (AnimRootMotionTransition.bFinishedLastFrame)
 	{
-		SLOG(FString::Printf(TEXT("Anim Root Motion Transition Finished %s"), *RootMotionSourceTransition.Name))
-		UE_LOG(LogTemp, Warning, TEXT("Anim Root Motion Transition Finished %s"), *AnimRootMotionTransition.Name)
+		SLOG(FString::Printf(TEXT("Anim Root Motion Transition Finished %s"), *AnimRootMotionTransition.Name.ToString()))
+		UE_LOG(LogTemp, Warning, TEXT("Anim Root Motion Transition Finished %s"), *AnimRootMotionTransition.Name.ToString())
 
-		const FString ARMTransitionName = AnimRootMotionTransition.Name;
+		const FXMUTransitionName ARMTransitionName = AnimRootMotionTransition.Name;
 		AnimRootMotionTransition.Reset();
 		PostAnimRootMotionTransition(ARMTransitionName);
 	}
@@ -399,10 +614,10 @@ void UXMUFoundationMovement::UpdateCharacterStateBeforeMovement(float DeltaSecon
 	
 	if (RootMotionSourceTransition.bFinishedLastFrame)
 	{
-		SLOG(FString::Printf(TEXT("Root Motion Source Transition Finished %s"), *RootMotionSourceTransition.Name))
-		UE_LOG(LogTemp, Warning, TEXT("Root Motion Source Transition Finished %s"), *RootMotionSourceTransition.Name)
+		SLOG(FString::Printf(TEXT("Root Motion Source Transition Finished %s"), *RootMotionSourceTransition.Name.ToString()))
+		UE_LOG(LogTemp, Warning, TEXT("Root Motion Source Transition Finished %s"), *RootMotionSourceTransition.Name.ToString())
 
-		const FString RMSTransitionName = RootMotionSourceTransition.Name;
+		const FXMUTransitionName RMSTransitionName = RootMotionSourceTransition.Name;
 		RootMotionSourceTransition.Reset();
 		PostRootMotionSourceTransition(RMSTransitionName);
 	}
@@ -414,6 +629,12 @@ void UXMUFoundationMovement::UpdateCharacterStateAfterMovement(float DeltaSecond
 {
 	UpdateCrouchAfterMovement(DeltaSeconds);
 
+	// Quantize the acceleration for simulated proxies now that it's final, it only gets marked dirty if it changed
+	if (FoundationCharacterOwner && FoundationCharacterOwner->HasAuthority())
+	{
+		FoundationCharacterOwner->UpdateReplicatedAcceleration(GetCurrentAcceleration(), MaxAcceleration, ReplicatedAccelerationMinSendInterval);
+	}
+
 	/*----------------------------------------------------------------------------------------------------------------*/
 	/* Track Root Motion Source End */
 	
@@ -455,19 +676,36 @@ void UXMUFoundationMovement::SimulateMovement(float DeltaTime)
 	const FVector OriginalAcceleration = Acceleration;
 	/*----------------------------------------------------------------------------------------------------------------*/
 
+	// Far and collision-free proxies keep walking on the floor they had, server updates correct them if they walked off it
+	bSkipProxyFloorCheck = (SimulatedProxyLOD == EXMUSimulatedProxyLOD::Far || bProxyCollisionDisabled) && IsMovingOnGround() && CurrentFloor.IsWalkableFloor();
 	Super::SimulateMovement(DeltaTime);
+	bSkipProxyFloorCheck = false;
 
-
+	// Simulated proxies don't replay moves, world time is good enough (and doesn't depend on the engine calling
+	// UpdateCharacterStateBeforeMovement from SimulateMovement)
+	MovementSimulationTime = GetWorld()->GetTimeSeconds();
 	
 	/*----------------------------------------------------------------------------------------------------------------*/
 	/* Restore replicated acceleration if needed */
 	if (bHasReplicatedAcceleration)
 	{
-		Acceleration = OriginalAcceleration;
+		Acceleration = bPredictReplicatedAcceleration ? PredictReplicatedAcceleration(GetWorld()->GetTimeSeconds()) : OriginalAcceleration;
 	}
 	/*----------------------------------------------------------------------------------------------------------------*/
 }
 
+void UXMUFoundationMovement::FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, bool bCanUseCachedResult, const FHitResult* DownwardSweepResult) const
+{
+	if (bSkipProxyFloorCheck)
+	{
+		XMU_COUNT_STAT(SimulatedProxySkippedFloorCheck);
+		OutFloorResult = CurrentFloor;
+		return;
+	}
+	
+	Super::FindFloor(CapsuleLocation, OutFloorResult, bCanUseCachedResult, DownwardSweepResult);
+}
+
 bool UXMUFoundationMovement::CanAttemptJump() const
 {
 	return IsJumpAllowed() &&
@@ -642,10 +880,76 @@ void UXMUFoundationMovement::CalcVelocity(float DeltaTime, float Friction, bool
 	}
 }
 
+void UXMUFoundationMovement::SimulatedTick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_XMUSimulatedTick);
+
+	if (HasValidData())
+	{
+		UpdateDistantProxyCollision();
+		if (bProxyCollisionDisabled)
+		{
+			XMU_COUNT_STAT(SimulatedProxyCollisionDisabled);
+		}
+	}
+	
+	// Networked root motion montages are simulated from the montage position, they can't be run in bigger steps
+	if (!bEnableSimulatedProxyLOD || !HasValidData() || CharacterOwner->IsPlayingNetworkedRootMotionMontage())
+	{
+		SetSimulatedProxyLOD(EXMUSimulatedProxyLOD::Full);
+		SimulatedProxyPendingTime = 0.f;
+		Super::SimulatedTick(DeltaSeconds);
+		return;
+	}
+
+	SetSimulatedProxyLOD(ComputeSimulatedProxyLOD());
+	switch (SimulatedProxyLOD)
+	{
+	case EXMUSimulatedProxyLOD::Full: XMU_COUNT_STAT(SimulatedProxyLODFull); break;
+	case EXMUSimulatedProxyLOD::Reduced: XMU_COUNT_STAT(SimulatedProxyLODReduced); break;
+	case EXMUSimulatedProxyLOD::Far: XMU_COUNT_STAT(SimulatedProxyLODFar); break;
+	}
+
+	SimulatedProxyPendingTime += DeltaSeconds;
+	if (SimulatedProxyPendingTime < GetSimulatedProxyTickInterval())
+	{
+		// Keep the mesh catching up with the last simulated location
+		SmoothClientPosition(DeltaSeconds);
+		XMU_COUNT_STAT(SimulatedProxySkippedTick);
+		return;
+	}
+
+	const float CatchUpTime = SimulatedProxyPendingTime;
+	SimulatedProxyPendingTime = 0.f;
+	const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+	
+	Super::SimulatedTick(CatchUpTime);
+
+	// Let the mesh interpolate over the step we just took instead of snapping to the end of it
+	if (SimulatedProxyLOD != EXMUSimulatedProxyLOD::Full && NetworkSmoothingMode == ENetworkSmoothingMode::Exponential)
+	{
+		FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character();
+		if (ClientData)
+		{
+			ClientData->MeshTranslationOffset += OldLocation - UpdatedComponent->GetComponentLocation();
+			bNetworkSmoothingComplete = false;
+			SmoothClientPosition(0.f);
+		}
+	}
+}
+
 void UXMUFoundationMovement::MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel)
 {
 	UpdateFromFoundationCompressedFlags();
+	
+	// Picked up by UpdateCharacterStateBeforeMovement
+	AutonomousMoveTimeStamp = ClientTimeStamp;
+	bHasAutonomousMoveTimeStamp = true;
+	
 	Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
+	
+	// In case the move got skipped before reaching PerformMovement
+	bHasAutonomousMoveTimeStamp = false;
 }
 
 void UXMUFoundationMovement::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
@@ -660,12 +964,20 @@ void UXMUFoundationMovement::OnMovementModeChanged(EMovementMode PreviousMovemen
 
 void UXMUFoundationMovement::UpdateStaminaBeforeMovement(float DeltaSeconds)
 {
-	SetStamina(GetStamina() + StaminaRegenRate * DeltaSeconds);
+	// Regeneration is applied lazily by GetStamina, it only needs to go through OnStaminaChanged on the move where it
+	// reaches the value that triggers drain / recover events
+	if (ResourceRegenClock >= StaminaRegenEventTime)
+	{
+		MaterializeStamina();
+	}
 }
 
 void UXMUFoundationMovement::UpdateChargeBeforeMovement(float DeltaSeconds)
 {
-	SetCharge(GetCharge() + ChargeRegenRate * DeltaSeconds);
+	if (ResourceRegenClock >= ChargeRegenEventTime)
+	{
+		MaterializeCharge();
+	}
 }
 
 void UXMUFoundationMovement::UpdateCoyoteTimeBeforeMovement(float DeltaSeconds)
@@ -767,170 +1079,743 @@ FVector UXMUFoundationMovement::GetControllerRightVector() const
 
 void UXMUFoundationMovement::SetReplicatedAcceleration(const FVector& InAcceleration)
 {
+	const double Time = GetWorld()->GetTimeSeconds();
+	// Acceleration is the value displayed last frame, the blend starts from the one that would be displayed now
+	const FVector DisplayedAcceleration = !bHasReplicatedAcceleration ? InAcceleration : bPredictReplicatedAcceleration ? PredictReplicatedAcceleration(Time) : Acceleration;
+	ReplicatedAccelerationPredictor.AddSample(InAcceleration, Time, DisplayedAcceleration);
 	bHasReplicatedAcceleration = true;
-	Acceleration = InAcceleration;
+	Acceleration = bPredictReplicatedAcceleration ? PredictReplicatedAcceleration(Time) : InAcceleration;
 }
 
-const FXMUCharacterGroundInfo& UXMUFoundationMovement::GetGroundInfo()
+FVector UXMUFoundationMovement::PredictReplicatedAcceleration(double Time) const
+{
+	return ReplicatedAccelerationPredictor.Predict(Time, ReplicatedAccelerationBlendTime, ReplicatedAccelerationMaxExtrapolationTime, FMath::DegreesToRadians(ReplicatedAccelerationMaxTurnRate));
+}
+
+void UXMUFoundationMovement::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
-	if (!CharacterOwner || (GFrameCounter == CachedGroundInfo.LastUpdateFrame))
+	if (bIdleSleeping)
 	{
-		return CachedGroundInfo;
+		if (CanIdleSleep())
+		{
+			XMU_COUNT_STAT(IdleSleeping);
+			return;
+		}
+		WakeFromIdleSleep();
 	}
+	
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	if (MovementMode == MOVE_Walking)
+	if (bEnableIdleSleep && CanIdleSleep())
 	{
-		CachedGroundInfo.GroundHitResult = CurrentFloor.HitResult;
-		CachedGroundInfo.GroundDistance = 0.0f;
+		IdleTime += DeltaTime;
+		if (IdleTime >= IdleSleepDelay)
+		{
+			EnterIdleSleep();
+		}
 	}
 	else
 	{
-		const UCapsuleComponent* CapsuleComp = CharacterOwner->GetCapsuleComponent();
-		check(CapsuleComp);
+		IdleTime = 0.f;
+	}
+}
 
-		const float CapsuleHalfHeight = CapsuleComp->GetUnscaledCapsuleHalfHeight();
-		const ECollisionChannel CollisionChannel = (UpdatedComponent ? UpdatedComponent->GetCollisionObjectType() : ECC_Pawn);
-		const FVector TraceStart(GetActorLocation());
-		const FVector TraceEnd(TraceStart.X, TraceStart.Y, (TraceStart.Z - XMUFoundationCharacter::GroundTraceDistance - CapsuleHalfHeight));
+EXMUSimulatedProxyLOD UXMUFoundationMovement::ComputeSimulatedProxyLOD() const
+{
+	if (XMUFoundationCharacter::ForceSimulatedProxyLOD >= 0)
+	{
+		return static_cast<EXMUSimulatedProxyLOD>(FMath::Min<int32>(XMUFoundationCharacter::ForceSimulatedProxyLOD, static_cast<int32>(EXMUSimulatedProxyLOD::Far)));
+	}
+	
+	const APlayerCameraManager* CameraManager = GetLocalCameraManager();
+	if (!CameraManager)
+	{
+		return EXMUSimulatedProxyLOD::Full;
+	}
 
-		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LyraCharacterMovementComponent_GetGroundInfo), false, CharacterOwner);
-		FCollisionResponseParams ResponseParam;
-		InitCollisionParams(QueryParams, ResponseParam);
+	const float Distance = FVector::Dist(CameraManager->GetCameraLocation(), UpdatedComponent->GetComponentLocation());
+	if (Distance > SimulatedProxyLODFarDistance || !CharacterOwner->WasRecentlyRendered(SimulatedProxyLODRenderTolerance))
+	{
+		return EXMUSimulatedProxyLOD::Far;
+	}
 
-		FHitResult HitResult;
-		GetWorld()->LineTraceSingleByChannel(HitResult, TraceStart, TraceEnd, CollisionChannel, QueryParams, ResponseParam);
+	// Fraction of the screen height covered by the capsule
+	const float HalfFOVRadians = FMath::DegreesToRadians(FMath::Clamp(CameraManager->GetFOVAngle(), 1.f, 170.f) * 0.5f);
+	const float ScreenSize = GetScaledCapsuleHalfHeight() / FMath::Max(Distance * FMath::Tan(HalfFOVRadians), UE_KINDA_SMALL_NUMBER);
+	if (ScreenSize < SimulatedProxyLODMinScreenSize)
+	{
+		return EXMUSimulatedProxyLOD::Far;
+	}
 
-		CachedGroundInfo.GroundHitResult = HitResult;
-		CachedGroundInfo.GroundDistance = XMUFoundationCharacter::GroundTraceDistance;
+	return Distance > SimulatedProxyLODNearDistance ? EXMUSimulatedProxyLOD::Reduced : EXMUSimulatedProxyLOD::Full;
+}
 
-		if (MovementMode == MOVE_NavWalking)
-		{
-			CachedGroundInfo.GroundDistance = 0.0f;
-		}
-		else if (HitResult.bBlockingHit)
-		{
-			CachedGroundInfo.GroundDistance = FMath::Max((HitResult.Distance - CapsuleHalfHeight), 0.0f);
-		}
+void UXMUFoundationMovement::SetSimulatedProxyLOD(EXMUSimulatedProxyLOD NewLOD)
+{
+	if (SimulatedProxyLOD == NewLOD)
+	{
+		return;
 	}
 
-	CachedGroundInfo.LastUpdateFrame = GFrameCounter;
+	SimulatedProxyLOD = NewLOD;
+	UpdateProxyCapsuleFreeze();
+}
 
-	return CachedGroundInfo;
+float UXMUFoundationMovement::GetSimulatedProxyTickInterval() const
+{
+	switch (SimulatedProxyLOD)
+	{
+	case EXMUSimulatedProxyLOD::Reduced: return SimulatedProxyReducedTickInterval;
+	case EXMUSimulatedProxyLOD::Far: return SimulatedProxyFarTickInterval;
+	default: return 0.f;
+	}
 }
 
-bool UXMUFoundationMovement::CheckOverrideJumpInput(float DeltaSeconds)
+const APlayerCameraManager* UXMUFoundationMovement::GetLocalCameraManager() const
 {
-	return false;
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	return PlayerController ? PlayerController->PlayerCameraManager.Get() : nullptr;
 }
 
-void UXMUFoundationMovement::ResizeCapsuleHH(float NewCapsuleHalfHeight, EXMUCapsuleScalingMode ScalingMode, bool bClientSimulation, FXMUResizeCapsuleHHResult& Result)
+void UXMUFoundationMovement::UpdateDistantProxyCollision()
 {
-	if (!HasValidData())
-	{
-		return;
-	}
-	
-	ACharacter* DefaultCharacter = CharacterOwner->GetClass()->GetDefaultObject<ACharacter>();
-	
-	// See if collision is already at desired size.
-	if (CharacterOwner->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight() == NewCapsuleHalfHeight)
+	bool bShouldDisableCollision = false;
+	if (bDisableDistantProxyCollision && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
 	{
-		if (!bClientSimulation)
+		if (const APlayerCameraManager* CameraManager = GetLocalCameraManager())
 		{
-			Result.Success = true;
+			// Hysteresis so proxies around the distance don't keep leaving and entering the physics scene
+			const float Distance = bProxyCollisionDisabled ? DistantProxyCollisionDistance - DistantProxyCollisionHysteresis : DistantProxyCollisionDistance;
+			bShouldDisableCollision = FVector::DistSquared(CameraManager->GetCameraLocation(), UpdatedComponent->GetComponentLocation()) > FMath::Square(FMath::Max(Distance, 0.f));
 		}
-		Result.HalfHeightAdjust = 0.f;
-		Result.ScaledHalfHeightAdjust = 0.f;
-		return;
 	}
-	
-	if (bClientSimulation && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
+
+	if (bShouldDisableCollision == bProxyCollisionDisabled)
 	{
-		// restore collision size before changing size
-		CharacterOwner->GetCapsuleComponent()->SetCapsuleSize(DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleRadius(), DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight());
-		bShrinkProxyCapsule = true;
+		return;
 	}
-	
-	const float ComponentScale = CharacterOwner->GetCapsuleComponent()->GetShapeScale();
-	const float OldUnscaledHalfHeight = CharacterOwner->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
-	const float OldUnscaledRadius = CharacterOwner->GetCapsuleComponent()->GetUnscaledCapsuleRadius();
-	// Height is not allowed to be smaller than radius.
-	const float ClampedNewHalfHeight = FMath::Max3(0.f, OldUnscaledRadius, NewCapsuleHalfHeight);
-	float HalfHeightAdjust = (ClampedNewHalfHeight - OldUnscaledHalfHeight);
-	float ScaledHalfHeightAdjust = HalfHeightAdjust * ComponentScale;
-	
-	
-	// Resizing
-	if (HalfHeightAdjust > 0.f)
+
+	UCapsuleComponent* Capsule = CharacterOwner->GetCapsuleComponent();
+	bProxyCollisionDisabled = bShouldDisableCollision;
+	if (bProxyCollisionDisabled)
 	{
-		IncreaseCapsuleHH(ClampedNewHalfHeight, ScaledHalfHeightAdjust, ScalingMode, bClientSimulation, Result);
+		ProxyCollisionEnabled = Capsule->GetCollisionEnabled();
+		Capsule->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		UpdateProxyCapsuleFreeze();
 	}
 	else
 	{
-		DecreaseCapsuleHH(ClampedNewHalfHeight, ScaledHalfHeightAdjust, ScalingMode, bClientSimulation, Result);
+		// Resize while still out of the physics scene, so the shape is only rebuilt once
+		UpdateProxyCapsuleFreeze();
+		Capsule->SetCollisionEnabled(ProxyCollisionEnabled);
 	}
-	
-	
-	// OnStartCrouch takes the change from the Default size, not the current one (though they are usually the same).
-	const float MeshAdjust = ScaledHalfHeightAdjust;
-	Result.HalfHeightAdjust = (DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight() - ClampedNewHalfHeight);
-	Result.ScaledHalfHeightAdjust = Result.HalfHeightAdjust * ComponentScale;
-	
-	AdjustProxyCapsuleSize();
+}
 
-	// Don't smooth this change in mesh position
-	if ((bClientSimulation && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy) || (IsNetMode(NM_ListenServer) && CharacterOwner->GetRemoteRole() == ROLE_AutonomousProxy))
+void UXMUFoundationMovement::UpdateProxyCapsuleFreeze()
+{
+	const bool bShouldFreeze = CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy
+		&& (bProxyCollisionDisabled || (bEnableSimulatedProxyLOD && SimulatedProxyLOD == EXMUSimulatedProxyLOD::Far));
+	if (bShouldFreeze == bProxyCapsuleFrozen)
 	{
-		FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character();
-		if (ClientData)
-		{
-			ClientData->MeshTranslationOffset += FVector(0.f, 0.f, MeshAdjust);
-			ClientData->OriginalMeshTranslationOffset = ClientData->MeshTranslationOffset;
-		}
+		return;
+	}
+
+	bProxyCapsuleFrozen = bShouldFreeze;
+	if (bProxyCapsuleFrozen || !bFrozenProxyCapsuleDirty || !HasValidData())
+	{
+		return;
 	}
+	bFrozenProxyCapsuleDirty = false;
+
+	// The mesh already follows the crouch state, only the collision has to catch up
+	XMU_COUNT_STAT(SimulatedProxyCapsuleThaw);
+	ACharacter* DefaultCharacter = CharacterOwner->GetClass()->GetDefaultObject<ACharacter>();
+	CharacterOwner->GetCapsuleComponent()->SetCapsuleSize(DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleRadius(), ProxyLogicalHalfHeight, !bProxyCollisionDisabled);
+	bShrinkProxyCapsule = true;
+	AdjustProxyCapsuleSize();
+	bForceNextFloorCheck = true;
 }
 
-void UXMUFoundationMovement::IncreaseCapsuleHH(float ClampedNewHalfHeight, float ScaledHalfHeightAdjust, EXMUCapsuleScalingMode ScalingMode, bool bClientSimulation, FXMUResizeCapsuleHHResult& Result)
+bool UXMUFoundationMovement::CanIdleSleep() const
 {
-	const float OldUnscaledRadius = CharacterOwner->GetCapsuleComponent()->GetUnscaledCapsuleRadius();
-	
-	if( !bClientSimulation )
+	if (!bEnableIdleSleep || !CharacterOwner || !UpdatedComponent || CharacterOwner->GetLocalRole() != ROLE_Authority || CharacterOwner->GetRemoteRole() == ROLE_AutonomousProxy)
 	{
-		const FVector PawnLocation = UpdatedComponent->GetComponentLocation();
-		const float CurrentHalfHeight = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
-		
-		// Try to stay in place and see if the larger capsule fits. We use a slightly taller capsule to avoid penetration.
-		const UWorld* MyWorld = GetWorld();
-		const float SweepInflation = UE_KINDA_SMALL_NUMBER * 10.f;
-		FCollisionQueryParams CapsuleParams(SCENE_QUERY_STAT(CrouchTrace), false, CharacterOwner);
-		FCollisionResponseParams ResponseParam;
-		InitCollisionParams(CapsuleParams, ResponseParam);
+		return false;
+	}
 
-		// Compensate for the difference between current capsule size and standing size
-		const FCollisionShape StandingCapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_HeightCustom, -SweepInflation - ScaledHalfHeightAdjust); // Shrink by negative amount, so actually grow it.
-		const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
-		bool bEncroached = true;
+	// Input, velocity and forces
+	if (MovementMode != MOVE_Walking || !Velocity.IsZero() || !Acceleration.IsZero() || !GetPendingInputVector().IsZero() || bHasRequestedVelocity
+		|| !PendingLaunchVelocity.IsZero() || !PendingImpulseToApply.IsZero() || !PendingForceToApply.IsZero() || CharacterOwner->bPressedJump
+		|| HasRootMotionSources() || HasAnimRootMotion())
+	{
+		return false;
+	}
 
-		if (ScalingMode == EXMUCapsuleScalingMode::CSM_Center)
-		{
-			// Expand in place
-			bEncroached = MyWorld->OverlapBlockingTestByChannel(PawnLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
-		
-			if (bEncroached)
-			{
-				// Try adjusting capsule position to see if we can avoid encroachment.
-				if (ScaledHalfHeightAdjust > 0.f)
-				{
-					// Shrink to a short capsule, sweep down to base to find where that would hit something, and then try to stand up from there.
-					float PawnRadius, PawnHalfHeight;
-					CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
-					const float ShrinkHalfHeight = PawnHalfHeight - PawnRadius;
+	// Crouch
+	if (bCrouchTransitioning || bWantsToCrouch != IsCrouching())
+	{
+		return false;
+	}
+
+	// Floor
+	const UPrimitiveComponent* FloorComponent = CurrentFloor.HitResult.GetComponent();
+	if (!CurrentFloor.IsWalkableFloor() || !FloorComponent || MovementBaseUtility::IsDynamicBase(FloorComponent) || bForceNextFloorCheck)
+	{
+		return false;
+	}
+
+	// Resources (stable if capped in the direction they regenerate)
+	auto IsResourceStable = [](float Value, float MaxValue, float RegenRate)
+	{
+		return RegenRate == 0.f || (RegenRate > 0.f && Value >= MaxValue) || (RegenRate < 0.f && Value <= 0.f);
+	};
+	if (!IsResourceStable(GetStamina(), MaxStamina, StaminaRegenRate) || !IsResourceStable(GetCharge(), MaxCharge, ChargeRegenRate) || CoyoteTimeDuration > 0.f)
+	{
+		return false;
+	}
+
+	// Moved or turned from outside the movement component
+	if (bIdleSleeping && (!UpdatedComponent->GetComponentLocation().Equals(IdleSleepLocation) || !CharacterOwner->GetControlRotation().Equals(IdleSleepControlRotation)))
+	{
+		return false;
+	}
+	
+	return true;
+}
+
+void UXMUFoundationMovement::EnterIdleSleep()
+{
+	bIdleSleeping = true;
+	IdleSleepLocation = UpdatedComponent->GetComponentLocation();
+	IdleSleepControlRotation = CharacterOwner->GetControlRotation();
+	XMU_COUNT_STAT(IdleSleepEnter);
+}
+
+void UXMUFoundationMovement::WakeFromIdleSleep()
+{
+	if (bIdleSleeping)
+	{
+		bIdleSleeping = false;
+		IdleTime = 0.f;
+		XMU_COUNT_STAT(IdleSleepWake);
+	}
+}
+
+const FXMUCharacterGroundInfo& UXMUFoundationMovement::GetGroundInfo()
+{
+	if (!CharacterOwner)
+	{
+		return CachedGroundInfo;
+	}
+
+	const UCapsuleComponent* CapsuleComp = CharacterOwner->GetCapsuleComponent();
+	check(CapsuleComp);
+	
+	// The cache is keyed on what the ground info depends on rather than on the frame, so it stays valid while the
+	// character doesn't move (even across frames) and gets refreshed by every replayed move or substep that moves it
+	const float CapsuleHalfHeight = CapsuleComp->GetUnscaledCapsuleHalfHeight();
+	const FVector Location(GetActorLocation());
+	const double SimulationTimeSinceUpdate = FMath::Abs(MovementSimulationTime - GroundInfoCacheKey.SimulationTime);
+	// Deferred results can change without us moving, so they are only reused within the frame (a new result arriving
+	// invalidates the cache, see ReceiveDeferredGroundHit)
+	const bool bDeferredGroundInfo = MovementMode != MOVE_Walking
+		&& (GroundInfoUpdateMode == EXMUGroundInfoUpdateMode::Asynchronous || GroundInfoUpdateMode == EXMUGroundInfoUpdateMode::Batched);
+	if (bGroundInfoCacheValid
+		&& GroundInfoCacheKey.MovementMode == MovementMode
+		&& GroundInfoCacheKey.CustomMovementMode == CustomMovementMode
+		&& GroundInfoCacheKey.CapsuleHalfHeight == CapsuleHalfHeight
+		&& GroundInfoCacheKey.Location.Equals(Location, XMUFoundationCharacter::GroundInfoCacheLocationTolerance)
+		&& SimulationTimeSinceUpdate <= XMUFoundationCharacter::GroundInfoCacheMaxAge
+		&& (!bDeferredGroundInfo || CachedGroundInfo.LastUpdateFrame == GFrameCounter))
+	{
+		return CachedGroundInfo;
+	}
+
+	GroundInfoCacheKey.Location = Location;
+	GroundInfoCacheKey.CapsuleHalfHeight = CapsuleHalfHeight;
+	GroundInfoCacheKey.SimulationTime = MovementSimulationTime;
+	GroundInfoCacheKey.MovementMode = MovementMode;
+	GroundInfoCacheKey.CustomMovementMode = CustomMovementMode;
+	bGroundInfoCacheValid = true;
+
+	if (MovementMode == MOVE_Walking)
+	{
+		CachedGroundInfo.GroundHitResult = CurrentFloor.HitResult;
+		CachedGroundInfo.GroundDistance = 0.0f;
+		CachedGroundInfo.TimeToLand = 0.0f;
+		CachedGroundInfo.bIsOutOfRange = false;
+		CachedGroundInfo.bIsStale = false;
+		bHasGroundPrediction = false;
+	}
+	else if (GroundInfoUpdateMode == EXMUGroundInfoUpdateMode::Predictive)
+	{
+		UpdateGroundInfoPredictive(CapsuleHalfHeight, Location);
+	}
+	else if (bDeferredGroundInfo && ReplayQueryCache.bActive)
+	{
+		UpdateGroundInfoReplayed(CapsuleHalfHeight, Location);
+	}
+	else if (bDeferredGroundInfo)
+	{
+		UpdateGroundInfoDeferred(CapsuleHalfHeight, Location);
+	}
+	else
+	{
+		UpdateGroundInfoSync(CapsuleHalfHeight, Location);
+	}
+
+	CachedGroundInfo.LastUpdateFrame = GFrameCounter;
+
+	return CachedGroundInfo;
+}
+
+void UXMUFoundationMovement::UpdateGroundInfoSync(float CapsuleHalfHeight, const FVector& TraceStart)
+{
+	const ECollisionChannel CollisionChannel = (UpdatedComponent ? UpdatedComponent->GetCollisionObjectType() : ECC_Pawn);
+	const FVector TraceEnd = GetGroundTraceEnd(CapsuleHalfHeight, TraceStart);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LyraCharacterMovementComponent_GetGroundInfo), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	InitCollisionParams(QueryParams, ResponseParam);
+
+	FHitResult HitResult;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_XMUGroundTrace);
+		CSV_SCOPED_TIMING_STAT(XMUMovement, GroundTrace);
+		LineTraceSingleByChannelCached(HitResult, TraceStart, TraceEnd, CollisionChannel, QueryParams, ResponseParam);
+	}
+
+	SetGroundInfoFromHit(HitResult, CapsuleHalfHeight, TraceStart);
+	CachedGroundInfo.TimeToLand = -1.0f;
+	CachedGroundInfo.bIsStale = false;
+}
+
+void UXMUFoundationMovement::UpdateGroundInfoPredictive(float CapsuleHalfHeight, const FVector& Location)
+{
+	const float GravityZ = GetGravityZ();
+	const float PredictionAge = static_cast<float>(MovementSimulationTime - GroundPredictionTime);
+	
+	// Negative age means we went back in time (replaying moves after a correction)
+	bool bRetrace = !bHasGroundPrediction || MovementMode != MOVE_Falling || PredictionAge < 0.0f || PredictionAge > GroundPredictionMaxAge;
+	if (!bRetrace)
+	{
+		// Horizontal velocity is constant and vertical velocity only changes with gravity while following the arc,
+		// anything else (jump, launch, air control, collision) means the prediction is no longer valid
+		const FVector PredictedVelocity(GroundPredictionVelocity.X, GroundPredictionVelocity.Y, GroundPredictionVelocity.Z + GravityZ * PredictionAge);
+		bRetrace = !Velocity.Equals(PredictedVelocity, GroundPredictionVelocityTolerance)
+			|| FVector::DistSquared2D(Location, GroundPredictionLocation) > FMath::Square(GroundPredictionDriftTolerance);
+	}
+
+	if (bRetrace)
+	{
+		XMU_COUNT_STAT(GroundInfoPredictionRetrace);
+		UpdateGroundInfoSync(CapsuleHalfHeight, Location);
+		GroundPredictionLocation = Location;
+		GroundPredictionVelocity = Velocity;
+		GroundPredictionTime = MovementSimulationTime;
+		bHasGroundPrediction = true;
+	}
+	else
+	{
+		XMU_COUNT_STAT(GroundInfoPredicted);
+		SetGroundInfoFromHit(CachedGroundInfo.GroundHitResult, CapsuleHalfHeight, Location);
+		CachedGroundInfo.bIsStale = true;
+	}
+
+	// Solve Height + Vz * t + 0.5 * GravityZ * t^2 = 0 for the first positive t
+	CachedGroundInfo.TimeToLand = -1.0f;
+	if (MovementMode == MOVE_NavWalking)
+	{
+		CachedGroundInfo.TimeToLand = 0.0f;
+	}
+	else if (CachedGroundInfo.GroundHitResult.bBlockingHit)
+	{
+		const float Height = CachedGroundInfo.GroundDistance;
+		if (Height <= 0.0f)
+		{
+			CachedGroundInfo.TimeToLand = 0.0f;
+		}
+		else if (GravityZ < -UE_KINDA_SMALL_NUMBER)
+		{
+			const float Discriminant = FMath::Square(Velocity.Z) - 2.0f * GravityZ * Height;
+			CachedGroundInfo.TimeToLand = (Velocity.Z + FMath::Sqrt(Discriminant)) / -GravityZ;
+		}
+		else if (Velocity.Z < -UE_KINDA_SMALL_NUMBER)
+		{
+			CachedGroundInfo.TimeToLand = Height / -Velocity.Z;
+		}
+	}
+}
+
+void UXMUFoundationMovement::UpdateGroundInfoDeferred(float CapsuleHalfHeight, const FVector& TraceStart)
+{
+	UWorld* World = GetWorld();
+	UXMUGroundQuerySubsystem* GroundQuerySubsystem = nullptr;
+	if (GroundInfoUpdateMode == EXMUGroundInfoUpdateMode::Batched)
+	{
+		GroundQuerySubsystem = World ? World->GetSubsystem<UXMUGroundQuerySubsystem>() : nullptr;
+		if (!GroundQuerySubsystem)
+		{
+			// Not available in this world type (e.g. editor preview)
+			UpdateGroundInfoSync(CapsuleHalfHeight, TraceStart);
+			return;
+		}
+	}
+	
+	// Serve the last completed trace if it is recent enough, otherwise (first frame in the air, or nobody asked for a
+	// while) pay for a synchronous trace so we never hand out a result from a completely different place
+	const bool bUseDeferredResult = bHasDeferredGroundHit && (GFrameCounter - DeferredGroundHitFrame) <= static_cast<uint64>(FMath::Max(XMUFoundationCharacter::GroundInfoMaxAsyncAge, 1));
+	if (bUseDeferredResult)
+	{
+		SetGroundInfoFromHit(DeferredGroundHitResult, CapsuleHalfHeight, TraceStart);
+		CachedGroundInfo.bIsStale = DeferredGroundHitFrame != GFrameCounter;
+	}
+	else
+	{
+		// Stands in for the deferred result for the rest of the frame, so other callers (and substeps, which move the
+		// character) don't each pay for their own synchronous trace
+		UpdateGroundInfoSync(CapsuleHalfHeight, TraceStart);
+		DeferredGroundHitResult = CachedGroundInfo.GroundHitResult;
+		DeferredGroundHitFrame = GFrameCounter;
+		bHasDeferredGroundHit = true;
+	}
+
+	// Only one request in flight, its result will be served next frame
+	const bool bHasPendingRequest = bGroundQueryQueued || (World && World->IsTraceHandleValid(GroundTraceHandle, false));
+	if (!World || bHasPendingRequest)
+	{
+		return;
+	}
+	
+	const ECollisionChannel CollisionChannel = (UpdatedComponent ? UpdatedComponent->GetCollisionObjectType() : ECC_Pawn);
+	const FVector TraceEnd = GetGroundTraceEnd(CapsuleHalfHeight, TraceStart);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(XMUFoundationMovement_GetGroundInfoDeferred), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	InitCollisionParams(QueryParams, ResponseParam);
+
+	if (GroundQuerySubsystem)
+	{
+		bGroundQueryQueued = true;
+		GroundQuerySubsystem->RequestGroundTrace({ this, TraceStart, TraceEnd, CollisionChannel, QueryParams, ResponseParam });
+	}
+	else
+	{
+		if (!GroundTraceDelegate.IsBound())
+		{
+			GroundTraceDelegate.BindUObject(this, &UXMUFoundationMovement::OnGroundTraceCompleted);
+		}
+		GroundTraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, TraceStart, TraceEnd, CollisionChannel, QueryParams, ResponseParam, &GroundTraceDelegate);
+	}
+}
+
+void UXMUFoundationMovement::UpdateGroundInfoReplayed(float CapsuleHalfHeight, const FVector& TraceStart)
+{
+	// Replayed moves happen back in time, where the deferred result (traced from the live location) doesn't apply and
+	// would look too old anyway. Trace synchronously, identical traces only run once per replay (see FXMUReplayQueryCache)
+	UpdateGroundInfoSync(CapsuleHalfHeight, TraceStart);
+
+	// Only then replace the deferred result: the last replayed move ends at the corrected location, so the live moves
+	// following the replay serve its result. The request in flight was made from before the correction
+	DeferredGroundHitResult = CachedGroundInfo.GroundHitResult;
+	DeferredGroundHitFrame = GFrameCounter;
+	bHasDeferredGroundHit = true;
+	GroundTraceHandle = FTraceHandle();
+}
+
+void UXMUFoundationMovement::OnGroundTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	if (TraceHandle != GroundTraceHandle)
+	{
+		return;
+	}
+	GroundTraceHandle = FTraceHandle();
+
+	ReceiveDeferredGroundHit(TraceDatum.OutHits.Num() > 0 ? TraceDatum.OutHits[0] : FHitResult(TraceDatum.Start, TraceDatum.End));
+}
+
+void UXMUFoundationMovement::ReceiveDeferredGroundHit(const FHitResult& HitResult)
+{
+	bGroundInfoCacheValid = false;
+	bGroundQueryQueued = false;
+	DeferredGroundHitResult = HitResult;
+	DeferredGroundHitFrame = GFrameCounter;
+	bHasDeferredGroundHit = true;
+}
+
+FVector UXMUFoundationMovement::GetGroundTraceEnd(float CapsuleHalfHeight, const FVector& TraceStart) const
+{
+	float TraceDistance = XMUFoundationCharacter::GroundTraceDistance;
+	
+	const float Lookahead = XMUFoundationCharacter::GroundTraceLookahead;
+	if (Lookahead > 0.0f)
+	{
+		// How far down we can get in Lookahead seconds. Anything further is reported as out of range, and will be
+		// found by a later trace well before we get there
+		const float GravityZ = FMath::Min(GetGravityZ(), 0.0f);
+		const float FallDistance = -(Velocity.Z * Lookahead + 0.5f * GravityZ * FMath::Square(Lookahead));
+		TraceDistance = FMath::Clamp(FallDistance, FMath::Min(XMUFoundationCharacter::GroundTraceMinDistance, TraceDistance), TraceDistance);
+	}
+
+	INC_DWORD_STAT(STAT_XMUGroundTraceCount);
+	INC_FLOAT_STAT_BY(STAT_XMUGroundTraceLength, TraceDistance);
+	CSV_CUSTOM_STAT(XMUMovement, GroundTraceCount, 1, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(XMUMovement, GroundTraceLength, TraceDistance, ECsvCustomStatOp::Accumulate);
+	
+	return FVector(TraceStart.X, TraceStart.Y, (TraceStart.Z - TraceDistance - CapsuleHalfHeight));
+}
+
+void UXMUFoundationMovement::SetGroundInfoFromHit(const FHitResult& HitResult, float CapsuleHalfHeight, const FVector& Location)
+{
+	CachedGroundInfo.GroundHitResult = HitResult;
+	CachedGroundInfo.bIsOutOfRange = false;
+
+	if (MovementMode == MOVE_NavWalking)
+	{
+		CachedGroundInfo.GroundDistance = 0.0f;
+	}
+	else if (HitResult.bBlockingHit)
+	{
+		// Measured from Location rather than from the trace start, which is the same for sync traces but lets async
+		// results follow the character while it falls
+		CachedGroundInfo.GroundDistance = FMath::Max((Location.Z - HitResult.ImpactPoint.Z - CapsuleHalfHeight), 0.0f);
+	}
+	else
+	{
+		// Nothing within the trace: the ground is at least as far as the end of the trace
+		CachedGroundInfo.bIsOutOfRange = true;
+		CachedGroundInfo.GroundDistance = FMath::Max((Location.Z - HitResult.TraceEnd.Z - CapsuleHalfHeight), 0.0f);
+	}
+}
+
+const FXMUCharacterHeadroomInfo& UXMUFoundationMovement::GetHeadroomInfo()
+{
+	if (!CharacterOwner || !UpdatedComponent)
+	{
+		return CachedHeadroomInfo;
+	}
+
+	// One sweep per move at most, shared by everything asking during that move
+	const float CapsuleHalfHeight = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	if (bHeadroomCacheValid
+		&& HeadroomCacheSimulationTime == MovementSimulationTime
+		&& HeadroomCacheHalfHeight == CapsuleHalfHeight
+		&& HeadroomCacheLocation.Equals(Location, UE_KINDA_SMALL_NUMBER))
+	{
+		return CachedHeadroomInfo;
+	}
+
+	HeadroomCacheLocation = Location;
+	HeadroomCacheHalfHeight = CapsuleHalfHeight;
+	HeadroomCacheSimulationTime = MovementSimulationTime;
+	bHeadroomCacheValid = true;
+	XMU_COUNT_STAT(HeadroomSweep);
+
+	FCollisionQueryParams CapsuleParams(SCENE_QUERY_STAT(XMUHeadroomTrace), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	InitCollisionParams(CapsuleParams, ResponseParam);
+
+	const FVector TraceEnd = Location + FVector(0.f, 0.f, HeadroomTraceDistance);
+	FHitResult Hit(1.f);
+	SweepSingleByChannelCached(Hit, Location, TraceEnd, UpdatedComponent->GetCollisionObjectType(), GetPawnCapsuleCollisionShape(SHRINK_None), CapsuleParams, ResponseParam);
+
+	CachedHeadroomInfo.CeilingHitResult = Hit;
+	CachedHeadroomInfo.bIsBlocked = Hit.bBlockingHit;
+	CachedHeadroomInfo.Clearance = Hit.bBlockingHit ? (Hit.bStartPenetrating ? 0.f : Hit.Time * HeadroomTraceDistance) : HeadroomTraceDistance;
+
+	return CachedHeadroomInfo;
+}
+
+bool UXMUFoundationMovement::CheckOverrideJumpInput(float DeltaSeconds)
+{
+	return false;
+}
+
+void UXMUFoundationMovement::ResizeCapsuleHH(float NewCapsuleHalfHeight, EXMUCapsuleScalingMode ScalingMode, bool bClientSimulation, FXMUResizeCapsuleHHResult& Result)
+{
+	if (!HasValidData())
+	{
+		return;
+	}
+	
+	ACharacter* DefaultCharacter = CharacterOwner->GetClass()->GetDefaultObject<ACharacter>();
+
+	if (bClientSimulation && bProxyCapsuleFrozen)
+	{
+		ResizeFrozenProxyCapsuleHH(NewCapsuleHalfHeight, Result);
+		return;
+	}
+	
+	// See if collision is already at desired size.
+	if (CharacterOwner->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight() == NewCapsuleHalfHeight)
+	{
+		if (bClientSimulation && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
+		{
+			ProxyLogicalHalfHeight = NewCapsuleHalfHeight;
+		}
+		if (!bClientSimulation)
+		{
+			Result.Success = true;
+		}
+		Result.HalfHeightAdjust = 0.f;
+		Result.ScaledHalfHeightAdjust = 0.f;
+		return;
+	}
+	
+	if (bClientSimulation && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		// restore collision size before changing size (no overlap update, the resize below does it)
+		CharacterOwner->GetCapsuleComponent()->SetCapsuleSize(DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleRadius(), DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight(), false);
+		bShrinkProxyCapsule = true;
+	}
+	
+	const float ComponentScale = CharacterOwner->GetCapsuleComponent()->GetShapeScale();
+	const float OldUnscaledHalfHeight = CharacterOwner->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+	const float OldUnscaledRadius = CharacterOwner->GetCapsuleComponent()->GetUnscaledCapsuleRadius();
+	// Height is not allowed to be smaller than radius.
+	const float ClampedNewHalfHeight = FMath::Max3(0.f, OldUnscaledRadius, NewCapsuleHalfHeight);
+	float HalfHeightAdjust = (ClampedNewHalfHeight - OldUnscaledHalfHeight);
+	float ScaledHalfHeightAdjust = HalfHeightAdjust * ComponentScale;
+	if (bClientSimulation && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		ProxyLogicalHalfHeight = ClampedNewHalfHeight;
+	}
+	
+	
+	// Resizing
+	if (HalfHeightAdjust > 0.f)
+	{
+		IncreaseCapsuleHH(ClampedNewHalfHeight, ScaledHalfHeightAdjust, ScalingMode, bClientSimulation, Result);
+	}
+	else
+	{
+		DecreaseCapsuleHH(ClampedNewHalfHeight, ScaledHalfHeightAdjust, ScalingMode, bClientSimulation, Result);
+	}
+	
+	
+	// OnStartCrouch takes the change from the Default size, not the current one (though they are usually the same).
+	const float MeshAdjust = ScaledHalfHeightAdjust;
+	Result.HalfHeightAdjust = (DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight() - ClampedNewHalfHeight);
+	Result.ScaledHalfHeightAdjust = Result.HalfHeightAdjust * ComponentScale;
+	
+	AdjustProxyCapsuleSize();
+
+	// Don't smooth this change in mesh position
+	if ((bClientSimulation && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy) || (IsNetMode(NM_ListenServer) && CharacterOwner->GetRemoteRole() == ROLE_AutonomousProxy))
+	{
+		FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character();
+		if (ClientData)
+		{
+			ClientData->MeshTranslationOffset += FVector(0.f, 0.f, MeshAdjust);
+			ClientData->OriginalMeshTranslationOffset = ClientData->MeshTranslationOffset;
+		}
+	}
+}
+
+void UXMUFoundationMovement::ResizeFrozenProxyCapsuleHH(float NewCapsuleHalfHeight, FXMUResizeCapsuleHHResult& Result)
+{
+	ACharacter* DefaultCharacter = CharacterOwner->GetClass()->GetDefaultObject<ACharacter>();
+	const float DefaultHalfHeight = DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+	if (ProxyLogicalHalfHeight < 0.f)
+	{
+		ProxyLogicalHalfHeight = DefaultHalfHeight;
+	}
+
+	// Same results as ResizeCapsuleHH, which restores the default size of proxies before resizing them
+	const float ComponentScale = CharacterOwner->GetCapsuleComponent()->GetShapeScale();
+	const float ClampedNewHalfHeight = FMath::Max3(0.f, DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleRadius(), NewCapsuleHalfHeight);
+	Result.HalfHeightAdjust = DefaultHalfHeight - ClampedNewHalfHeight;
+	Result.ScaledHalfHeightAdjust = Result.HalfHeightAdjust * ComponentScale;
+	if (ProxyLogicalHalfHeight == ClampedNewHalfHeight)
+	{
+		return;
+	}
+	XMU_COUNT_STAT(SimulatedProxyFrozenCapsuleResize);
+
+	const float MeshAdjust = (ClampedNewHalfHeight - DefaultHalfHeight) * ComponentScale;
+	ProxyLogicalHalfHeight = ClampedNewHalfHeight;
+	bFrozenProxyCapsuleDirty = true;
+
+	// Don't smooth this change in mesh position
+	FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character();
+	if (ClientData)
+	{
+		ClientData->MeshTranslationOffset += FVector(0.f, 0.f, MeshAdjust);
+		ClientData->OriginalMeshTranslationOffset = ClientData->MeshTranslationOffset;
+	}
+}
+
+void UXMUFoundationMovement::IncreaseCapsuleHH(float ClampedNewHalfHeight, float ScaledHalfHeightAdjust, EXMUCapsuleScalingMode ScalingMode, bool bClientSimulation, FXMUResizeCapsuleHHResult& Result)
+{
+	const float OldUnscaledRadius = CharacterOwner->GetCapsuleComponent()->GetUnscaledCapsuleRadius();
+	
+	if( !bClientSimulation )
+	{
+		// Checked first so repeated attempts from the same spot don't run any query, not even the headroom sweep
+		if (MatchesEncroachmentMemo(ClampedNewHalfHeight, ScalingMode))
+		{
+			// Failed from this exact spot already and nothing around us moved
+			XMU_COUNT_STAT(EncroachmentMemoHit);
+			return;
+		}
+		
+		const FVector PawnLocation = UpdatedComponent->GetComponentLocation();
+		const float CurrentHalfHeight = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+		
+		// Try to stay in place and see if the larger capsule fits. We use a slightly taller capsule to avoid penetration.
+		const float SweepInflation = UE_KINDA_SMALL_NUMBER * 10.f;
+		FCollisionQueryParams CapsuleParams(SCENE_QUERY_STAT(CrouchTrace), false, CharacterOwner);
+		FCollisionResponseParams ResponseParam;
+		InitCollisionParams(CapsuleParams, ResponseParam);
+		
+		// Reject resizes that can't fit under the ceiling without running any overlap test. Growing from the center
+		// needs at least half the growth above us, growing from the bottom needs all of it (minus how much closer to
+		// the floor we can get)
+		const FXMUCharacterHeadroomInfo& HeadroomInfo = GetHeadroomInfo();
+		if (HeadroomInfo.bIsBlocked && ScalingMode != EXMUCapsuleScalingMode::CSM_Top)
+		{
+			float RequiredClearance = ScaledHalfHeightAdjust;
+			if (ScalingMode == EXMUCapsuleScalingMode::CSM_Bottom)
+			{
+				const float FloorAdjust = (IsMovingOnGround() && CurrentFloor.bBlockingHit) ? CurrentFloor.FloorDist : 0.f;
+				RequiredClearance = 2.f * ScaledHalfHeightAdjust - FloorAdjust;
+			}
+			
+			if (HeadroomInfo.Clearance + UE_KINDA_SMALL_NUMBER < RequiredClearance)
+			{
+				XMU_COUNT_STAT(HeadroomRejected);
+				// Memoized like an encroachment, so the next attempts from here skip the headroom sweep too
+				RecordEncroachmentMemo(ClampedNewHalfHeight, ScaledHalfHeightAdjust, ScalingMode, CapsuleParams, ResponseParam);
+				return;
+			}
+		}
+
+		// Compensate for the difference between current capsule size and standing size
+		const FCollisionShape StandingCapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_HeightCustom, -SweepInflation - ScaledHalfHeightAdjust); // Shrink by negative amount, so actually grow it.
+		const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
+		bool bEncroached = true;
+
+		if (ScalingMode == EXMUCapsuleScalingMode::CSM_Center)
+		{
+			// Expand in place
+			bEncroached = OverlapBlockingTestByChannelCached(PawnLocation, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+		
+			if (bEncroached)
+			{
+				// Try adjusting capsule position to see if we can avoid encroachment.
+				if (ScaledHalfHeightAdjust > 0.f)
+				{
+					// Shrink to a short capsule, sweep down to base to find where that would hit something, and then try to stand up from there.
+					float PawnRadius, PawnHalfHeight;
+					CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
+					const float ShrinkHalfHeight = PawnHalfHeight - PawnRadius;
 					const float TraceDist = PawnHalfHeight - ShrinkHalfHeight;
 					const FVector Down = FVector(0.f, 0.f, -TraceDist);
 
 					FHitResult Hit(1.f);
 					const FCollisionShape ShortCapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_HeightCustom, ShrinkHalfHeight);
-					const bool bBlockingHit = MyWorld->SweepSingleByChannel(Hit, PawnLocation, PawnLocation + Down, FQuat::Identity, CollisionChannel, ShortCapsuleShape, CapsuleParams);
+					const bool bBlockingHit = SweepSingleByChannelCached(Hit, PawnLocation, PawnLocation + Down, CollisionChannel, ShortCapsuleShape, CapsuleParams);
 					if (Hit.bStartPenetrating)
 					{
 						bEncroached = true;
@@ -940,7 +1825,7 @@ void UXMUFoundationMovement::IncreaseCapsuleHH(float ClampedNewHalfHeight, float
 						// Compute where the base of the sweep ended up, and see if we can stand there
 						const float DistanceToBase = (Hit.Time * TraceDist) + ShortCapsuleShape.Capsule.HalfHeight;
 						const FVector NewLoc = FVector(PawnLocation.X, PawnLocation.Y, PawnLocation.Z - DistanceToBase + StandingCapsuleShape.Capsule.HalfHeight + SweepInflation + MIN_FLOOR_DIST / 2.f);
-						bEncroached = MyWorld->OverlapBlockingTestByChannel(NewLoc, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+						bEncroached = OverlapBlockingTestByChannelCached(NewLoc, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
 						if (!bEncroached)
 						{
 							// Intentionally not using MoveUpdatedComponent, where a horizontal plane constraint would prevent the base of the capsule from staying at the same spot.
@@ -954,45 +1839,169 @@ void UXMUFoundationMovement::IncreaseCapsuleHH(float ClampedNewHalfHeight, float
 		{
 			// Expand while keeping base location the same.
 			FVector StandingLocation = PawnLocation + FVector(0.f, 0.f, StandingCapsuleShape.GetCapsuleHalfHeight() - CurrentHalfHeight);
-			bEncroached = MyWorld->OverlapBlockingTestByChannel(StandingLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+			bEncroached = OverlapBlockingTestByChannelCached(StandingLocation, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+
+			if (bEncroached)
+			{
+				if (IsMovingOnGround())
+				{
+					// Something might be just barely overhead, try moving down closer to the floor to avoid it.
+					const float MinFloorDist = UE_KINDA_SMALL_NUMBER * 10.f;
+					if (CurrentFloor.bBlockingHit && CurrentFloor.FloorDist > MinFloorDist)
+					{
+						StandingLocation.Z -= CurrentFloor.FloorDist - MinFloorDist;
+						bEncroached = OverlapBlockingTestByChannelCached(StandingLocation, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+					}
+				}				
+			}
+
+			if (!bEncroached)
+			{
+				// Commit the change in location.
+				UpdatedComponent->MoveComponent(StandingLocation - PawnLocation, UpdatedComponent->GetComponentQuat(), false, nullptr, EMoveComponentFlags::MOVECOMP_NoFlags, ETeleportType::TeleportPhysics);
+				bForceNextFloorCheck = true;
+			}
+		}
+		else if (ScalingMode == EXMUCapsuleScalingMode::CSM_Top)
+		{
+			// TODO: add
+		}
+
+		// If still encroached then abort.
+		if (bEncroached)
+		{
+			RecordEncroachmentMemo(ClampedNewHalfHeight, ScaledHalfHeightAdjust, ScalingMode, CapsuleParams, ResponseParam);
+			return;
+		}
+
+		EncroachmentMemo.Reset();
+		Result.Success = true;
+	}
+
+	// Now call SetCapsuleSize() to cause touch/untouch events and actually grow the capsule
+	CharacterOwner->GetCapsuleComponent()->SetCapsuleSize(OldUnscaledRadius, ClampedNewHalfHeight, true);
+}
+
+bool UXMUFoundationMovement::LineTraceSingleByChannelCached(FHitResult& OutHit, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel, const FCollisionQueryParams& Params, const FCollisionResponseParams& ResponseParam)
+{
+	if (!ReplayQueryCache.bActive)
+	{
+		return GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, TraceChannel, Params, ResponseParam);
+	}
+
+	const FXMUReplayQueryCache::FKey Key { Params.TraceTag, Start, End, FVector::ZeroVector, TraceChannel, FXMUReplayQueryCache::EQueryType::LineTrace, 0 };
+	if (const FXMUReplayQueryCache::FResult* Result = ReplayQueryCache.Results.Find(Key))
+	{
+		++ReplayQueryCache.NumHits;
+		OutHit = Result->Hit;
+		return Result->bBlocking;
+	}
+
+	++ReplayQueryCache.NumMisses;
+	const bool bBlocking = GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, TraceChannel, Params, ResponseParam);
+	ReplayQueryCache.Results.Add(Key, { OutHit, bBlocking });
+	return bBlocking;
+}
+
+bool UXMUFoundationMovement::SweepSingleByChannelCached(FHitResult& OutHit, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel, const FCollisionShape& CollisionShape, const FCollisionQueryParams& Params, const FCollisionResponseParams& ResponseParam)
+{
+	if (!ReplayQueryCache.bActive)
+	{
+		return GetWorld()->SweepSingleByChannel(OutHit, Start, End, FQuat::Identity, TraceChannel, CollisionShape, Params, ResponseParam);
+	}
+
+	const FXMUReplayQueryCache::FKey Key { Params.TraceTag, Start, End, CollisionShape.GetExtent(), TraceChannel, FXMUReplayQueryCache::EQueryType::Sweep, static_cast<uint8>(CollisionShape.ShapeType) };
+	if (const FXMUReplayQueryCache::FResult* Result = ReplayQueryCache.Results.Find(Key))
+	{
+		++ReplayQueryCache.NumHits;
+		OutHit = Result->Hit;
+		return Result->bBlocking;
+	}
+
+	++ReplayQueryCache.NumMisses;
+	const bool bBlocking = GetWorld()->SweepSingleByChannel(OutHit, Start, End, FQuat::Identity, TraceChannel, CollisionShape, Params, ResponseParam);
+	ReplayQueryCache.Results.Add(Key, { OutHit, bBlocking });
+	return bBlocking;
+}
+
+bool UXMUFoundationMovement::OverlapBlockingTestByChannelCached(const FVector& Pos, ECollisionChannel TraceChannel, const FCollisionShape& CollisionShape, const FCollisionQueryParams& Params, const FCollisionResponseParams& ResponseParam)
+{
+	if (!ReplayQueryCache.bActive)
+	{
+		return GetWorld()->OverlapBlockingTestByChannel(Pos, FQuat::Identity, TraceChannel, CollisionShape, Params, ResponseParam);
+	}
 
-			if (bEncroached)
-			{
-				if (IsMovingOnGround())
-				{
-					// Something might be just barely overhead, try moving down closer to the floor to avoid it.
-					const float MinFloorDist = UE_KINDA_SMALL_NUMBER * 10.f;
-					if (CurrentFloor.bBlockingHit && CurrentFloor.FloorDist > MinFloorDist)
-					{
-						StandingLocation.Z -= CurrentFloor.FloorDist - MinFloorDist;
-						bEncroached = MyWorld->OverlapBlockingTestByChannel(StandingLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
-					}
-				}				
-			}
+	const FXMUReplayQueryCache::FKey Key { Params.TraceTag, Pos, Pos, CollisionShape.GetExtent(), TraceChannel, FXMUReplayQueryCache::EQueryType::OverlapBlocking, static_cast<uint8>(CollisionShape.ShapeType) };
+	if (const FXMUReplayQueryCache::FResult* Result = ReplayQueryCache.Results.Find(Key))
+	{
+		++ReplayQueryCache.NumHits;
+		return Result->bBlocking;
+	}
 
-			if (!bEncroached)
-			{
-				// Commit the change in location.
-				UpdatedComponent->MoveComponent(StandingLocation - PawnLocation, UpdatedComponent->GetComponentQuat(), false, nullptr, EMoveComponentFlags::MOVECOMP_NoFlags, ETeleportType::TeleportPhysics);
-				bForceNextFloorCheck = true;
-			}
-		}
-		else if (ScalingMode == EXMUCapsuleScalingMode::CSM_Top)
+	++ReplayQueryCache.NumMisses;
+	const bool bBlocking = GetWorld()->OverlapBlockingTestByChannel(Pos, FQuat::Identity, TraceChannel, CollisionShape, Params, ResponseParam);
+	ReplayQueryCache.Results.Add(Key, { FHitResult(), bBlocking });
+	return bBlocking;
+}
+
+bool UXMUFoundationMovement::MatchesEncroachmentMemo(float ClampedNewHalfHeight, EXMUCapsuleScalingMode ScalingMode) const
+{
+	if (!EncroachmentMemo.bValid
+		|| EncroachmentMemo.TargetHalfHeight != ClampedNewHalfHeight
+		|| EncroachmentMemo.ScalingMode != ScalingMode
+		|| EncroachmentMemo.MovementMode != MovementMode
+		|| EncroachmentMemo.FloorDist != CurrentFloor.FloorDist
+		|| !EncroachmentMemo.Location.Equals(UpdatedComponent->GetComponentLocation(), UE_KINDA_SMALL_NUMBER))
+	{
+		return false;
+	}
+
+	for (const FXMUEncroachmentMemo::FBlocker& Blocker : EncroachmentMemo.Blockers)
+	{
+		const UPrimitiveComponent* BlockerComponent = Blocker.Component.Get();
+		if (!BlockerComponent || !BlockerComponent->IsCollisionEnabled() || !BlockerComponent->GetComponentTransform().Equals(Blocker.Transform, UE_KINDA_SMALL_NUMBER))
 		{
-			// TODO: add
+			return false;
 		}
+	}
+	
+	return true;
+}
 
-		// If still encroached then abort.
-		if (bEncroached)
+void UXMUFoundationMovement::RecordEncroachmentMemo(float ClampedNewHalfHeight, float ScaledHalfHeightAdjust, EXMUCapsuleScalingMode ScalingMode, const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams)
+{
+	EncroachmentMemo.Reset();
+	
+	// One overlap covering everything IncreaseCapsuleHH may have tested: the standing capsule placed anywhere between
+	// the bottom of the current capsule and the top of a standing capsule grown from the center
+	const FVector PawnLocation = UpdatedComponent->GetComponentLocation();
+	const float CurrentHalfHeight = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const FCollisionShape AreaShape = GetPawnCapsuleCollisionShape(SHRINK_HeightCustom, -2.f * ScaledHalfHeightAdjust - MIN_FLOOR_DIST);
+	
+	TArray<FOverlapResult> Overlaps;
+	GetWorld()->OverlapMultiByChannel(Overlaps, PawnLocation, FQuat::Identity, UpdatedComponent->GetCollisionObjectType(), AreaShape, QueryParams, ResponseParams);
+
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		if (Overlap.bBlockingHit && Overlap.Component.IsValid())
 		{
-			return;
+			EncroachmentMemo.Blockers.Add({ Overlap.Component.Get(), Overlap.Component->GetComponentTransform() });
 		}
-
-		Result.Success = true;
 	}
 
-	// Now call SetCapsuleSize() to cause touch/untouch events and actually grow the capsule
-	CharacterOwner->GetCapsuleComponent()->SetCapsuleSize(OldUnscaledRadius, ClampedNewHalfHeight, true);
+	// Without knowing what blocked us we can't tell when it stops doing so
+	if (EncroachmentMemo.Blockers.IsEmpty())
+	{
+		return;
+	}
+	
+	EncroachmentMemo.Location = PawnLocation;
+	EncroachmentMemo.TargetHalfHeight = ClampedNewHalfHeight;
+	EncroachmentMemo.ScalingMode = ScalingMode;
+	EncroachmentMemo.MovementMode = MovementMode;
+	EncroachmentMemo.FloorDist = CurrentFloor.FloorDist;
+	EncroachmentMemo.bValid = true;
+	XMU_COUNT_STAT(EncroachmentMemoRecorded);
 }
 
 void UXMUFoundationMovement::DecreaseCapsuleHH(float ClampedNewHalfHeight, float ScaledHalfHeightAdjust, EXMUCapsuleScalingMode ScalingMode, bool bClientSimulation, FXMUResizeCapsuleHHResult& Result)
@@ -1024,7 +2033,7 @@ void UXMUFoundationMovement::DecreaseCapsuleHH(float ClampedNewHalfHeight, float
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Anim Root Motion Transitions */
 
-void UXMUFoundationMovement::PostAnimRootMotionTransition(FString TransitionName)
+void UXMUFoundationMovement::PostAnimRootMotionTransition(FXMUTransitionName TransitionName)
 {
 }
 
@@ -1033,7 +2042,7 @@ void UXMUFoundationMovement::PostAnimRootMotionTransition(FString TransitionName
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Root Motion Source Transitions */
 
-void UXMUFoundationMovement::PostRootMotionSourceTransition(FString TransitionName)
+void UXMUFoundationMovement::PostRootMotionSourceTransition(FXMUTransitionName TransitionName)
 {
 }
 
@@ -1227,6 +2236,14 @@ void UXMUFoundationMovement::DebugCoyoteTimeDuration() const
 #endif
 }
 
+FXMUNetQuantizedRange UXMUFoundationMovement::GetNetworkCoyoteTimeDurationQuantization() const
+{
+	// Both ends of the connection must agree on the encoding, so it only depends on class defaults (MaxCoyoteTimeDuration can be
+	// changed at runtime and is not replicated). Values above the default max are sent raw
+	const UXMUFoundationMovement* Defaults = GetClass()->GetDefaultObject<UXMUFoundationMovement>();
+	return FXMUNetQuantizedRange(Defaults->MaxCoyoteTimeDuration, FXMUNetQuantizedRange::GetRequiredBits(Defaults->MaxCoyoteTimeDuration, Defaults->NetworkCoyoteTimeDurationCorrectionThreshold, Defaults->NetworkCoyoteTimeDurationQuantizationBits));
+}
+
 void UXMUFoundationMovement::OnCoyoteTimeDurationChanged(float PrevValue, float NewValue)
 {
 }
@@ -1238,8 +2255,25 @@ void UXMUFoundationMovement::OnCoyoteTimeDurationChanged(float PrevValue, float
 
 void UXMUFoundationMovement::SetStamina(float NewStamina)
 {
-	const float PrevStamina = Stamina;
+	const float PrevStamina = GetStamina();
 	Stamina = FMath::Clamp(NewStamina, 0.f, MaxStamina);
+	StaminaAnchorTime = ResourceRegenClock;
+	if (CharacterOwner != nullptr)
+	{
+		if (!FMath::IsNearlyEqual(PrevStamina, Stamina))
+		{
+			OnStaminaChanged(PrevStamina, Stamina);
+		}
+	}
+	UpdateStaminaRegenEventTime();
+}
+
+void UXMUFoundationMovement::MaterializeStamina()
+{
+	// Unlike SetStamina, the previous value is the one the last OnStaminaChanged saw
+	const float PrevStamina = Stamina;
+	Stamina = GetStamina();
+	StaminaAnchorTime = ResourceRegenClock;
 	if (CharacterOwner != nullptr)
 	{
 		if (!FMath::IsNearlyEqual(PrevStamina, Stamina))
@@ -1247,10 +2281,26 @@ void UXMUFoundationMovement::SetStamina(float NewStamina)
 			OnStaminaChanged(PrevStamina, Stamina);
 		}
 	}
+	UpdateStaminaRegenEventTime();
+}
+
+void UXMUFoundationMovement::UpdateStaminaRegenEventTime()
+{
+	const float Remaining = GetStaminaRegenEventValue() - Stamina;
+	if (StaminaRegenRate == 0.f || FMath::IsNearlyZero(Remaining) || FMath::Sign(Remaining) != FMath::Sign(StaminaRegenRate))
+	{
+		// Already there, or never getting there
+		StaminaRegenEventTime = TNumericLimits<double>::Max();
+		return;
+	}
+	StaminaRegenEventTime = StaminaAnchorTime + Remaining / StaminaRegenRate;
 }
 
 void UXMUFoundationMovement::SetMaxStamina(float NewMaxStamina)
 {
+	// Regeneration so far was clamped by the old max
+	MaterializeStamina();
+	
 	const float PrevMaxStamina = MaxStamina;
 	MaxStamina = FMath::Max(0.f, NewMaxStamina);
 	if (CharacterOwner != nullptr)
@@ -1260,6 +2310,7 @@ void UXMUFoundationMovement::SetMaxStamina(float NewMaxStamina)
 			OnMaxStaminaChanged(PrevMaxStamina, MaxStamina);
 		}
 	}
+	UpdateStaminaRegenEventTime();
 }
 
 void UXMUFoundationMovement::SetStaminaDrained(bool bNewValue)
@@ -1299,32 +2350,52 @@ void UXMUFoundationMovement::DebugStamina() const
 #endif
 }
 
+FXMUNetQuantizedRange UXMUFoundationMovement::GetNetworkStaminaQuantization() const
+{
+	// Both ends of the connection must agree on the encoding, so it only depends on class defaults (MaxStamina can be
+	// changed at runtime and is not replicated). Values above the default max are sent raw
+	const UXMUFoundationMovement* Defaults = GetClass()->GetDefaultObject<UXMUFoundationMovement>();
+	return FXMUNetQuantizedRange(Defaults->MaxStamina, FXMUNetQuantizedRange::GetRequiredBits(Defaults->MaxStamina, Defaults->NetworkStaminaCorrectionThreshold, Defaults->NetworkStaminaQuantizationBits));
+}
+
 void UXMUFoundationMovement::OnStaminaChanged(float PrevValue, float NewValue)
 {
 	if (FMath::IsNearlyZero(Stamina))
 	{
 		Stamina = 0.f;
-		if (!bStaminaDrained)
-		{
-			SetStaminaDrained(true);
-		}
+	}
+	else if (FMath::IsNearlyEqual(Stamina, MaxStamina))
+	{
+		Stamina = MaxStamina;
+	}
+
+	const bool bNewDrained = GetStaminaDrainedAfterChange(Stamina, bStaminaDrained);
+	if (bNewDrained != bStaminaDrained)
+	{
+		SetStaminaDrained(bNewDrained);
+	}
+}
+
+bool UXMUFoundationMovement::GetStaminaDrainedAfterChange(float NewValue, bool bWasDrained) const
+{
+	if (FMath::IsNearlyZero(NewValue))
+	{
+		return true;
 	}
 	// This will need to change if not using MaxStamina for recovery, here is an example (commented out) that uses
 	// 10% instead; to use this, comment out the existing else if statement, and change the 0.1f to the percentage
-	// you want to use (0.1f is 10%)
+	// you want to use (0.1f is 10%). GetStaminaRegenEventValue must then return MaxStamina * 0.1f while drained, so
+	// regeneration gets materialized when crossing it
 	//
-	// else if (bStaminaDrained && Stamina >= MaxStamina * 0.1f)
+	// else if (bWasDrained && NewValue >= MaxStamina * 0.1f)
 	// {
-	// 	SetStaminaDrained(false);
+	// 	return false;
 	// }
-	else if (FMath::IsNearlyEqual(Stamina, MaxStamina))
+	else if (FMath::IsNearlyEqual(NewValue, MaxStamina))
 	{
-		Stamina = MaxStamina;
-		if (bStaminaDrained)
-		{
-			SetStaminaDrained(false);
-		}
+		return false;
 	}
+	return bWasDrained;
 }
 
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -1334,8 +2405,9 @@ void UXMUFoundationMovement::OnStaminaChanged(float PrevValue, float NewValue)
 
 void UXMUFoundationMovement::SetCharge(float NewCharge)
 {
-	const float PrevCharge = Charge;
+	const float PrevCharge = GetCharge();
 	Charge = FMath::Clamp(NewCharge, 0.f, MaxCharge);
+	ChargeAnchorTime = ResourceRegenClock;
 	if (CharacterOwner != nullptr)
 	{
 		if (!FMath::IsNearlyEqual(PrevCharge, Charge))
@@ -1343,10 +2415,42 @@ void UXMUFoundationMovement::SetCharge(float NewCharge)
 			OnChargeChanged(PrevCharge, Charge);
 		}
 	}
+	UpdateChargeRegenEventTime();
+}
+
+void UXMUFoundationMovement::MaterializeCharge()
+{
+	// Unlike SetCharge, the previous value is the one the last OnChargeChanged saw
+	const float PrevCharge = Charge;
+	Charge = GetCharge();
+	ChargeAnchorTime = ResourceRegenClock;
+	if (CharacterOwner != nullptr)
+	{
+		if (!FMath::IsNearlyEqual(PrevCharge, Charge))
+		{
+			OnChargeChanged(PrevCharge, Charge);
+		}
+	}
+	UpdateChargeRegenEventTime();
+}
+
+void UXMUFoundationMovement::UpdateChargeRegenEventTime()
+{
+	const float Remaining = GetChargeRegenEventValue() - Charge;
+	if (ChargeRegenRate == 0.f || FMath::IsNearlyZero(Remaining) || FMath::Sign(Remaining) != FMath::Sign(ChargeRegenRate))
+	{
+		// Already there, or never getting there
+		ChargeRegenEventTime = TNumericLimits<double>::Max();
+		return;
+	}
+	ChargeRegenEventTime = ChargeAnchorTime + Remaining / ChargeRegenRate;
 }
 
 void UXMUFoundationMovement::SetMaxCharge(float NewMaxCharge)
 {
+	// Regeneration so far was clamped by the old max
+	MaterializeCharge();
+	
 	const float PrevMaxCharge = MaxCharge;
 	MaxCharge = FMath::Max(0.f, NewMaxCharge);
 	if (CharacterOwner != nullptr)
@@ -1356,6 +2460,7 @@ void UXMUFoundationMovement::SetMaxCharge(float NewMaxCharge)
 			OnMaxChargeChanged(PrevMaxCharge, MaxCharge);
 		}
 	}
+	UpdateChargeRegenEventTime();
 }
 
 void UXMUFoundationMovement::SetChargeDrained(bool bNewValue)
@@ -1395,32 +2500,52 @@ void UXMUFoundationMovement::DebugCharge() const
 #endif
 }
 
+FXMUNetQuantizedRange UXMUFoundationMovement::GetNetworkChargeQuantization() const
+{
+	// Both ends of the connection must agree on the encoding, so it only depends on class defaults (MaxCharge can be
+	// changed at runtime and is not replicated). Values above the default max are sent raw
+	const UXMUFoundationMovement* Defaults = GetClass()->GetDefaultObject<UXMUFoundationMovement>();
+	return FXMUNetQuantizedRange(Defaults->MaxCharge, FXMUNetQuantizedRange::GetRequiredBits(Defaults->MaxCharge, Defaults->NetworkChargeCorrectionThreshold, Defaults->NetworkChargeQuantizationBits));
+}
+
 void UXMUFoundationMovement::OnChargeChanged(float PrevValue, float NewValue)
 {
 	if (FMath::IsNearlyZero(Charge))
 	{
 		Charge = 0.f;
-		if (!bChargeDrained)
-		{
-			SetChargeDrained(true);
-		}
+	}
+	else if (FMath::IsNearlyEqual(Charge, MaxCharge))
+	{
+		Charge = MaxCharge;
+	}
+
+	const bool bNewDrained = GetChargeDrainedAfterChange(Charge, bChargeDrained);
+	if (bNewDrained != bChargeDrained)
+	{
+		SetChargeDrained(bNewDrained);
+	}
+}
+
+bool UXMUFoundationMovement::GetChargeDrainedAfterChange(float NewValue, bool bWasDrained) const
+{
+	if (FMath::IsNearlyZero(NewValue))
+	{
+		return true;
 	}
 	// This will need to change if not using MaxCharge for recovery, here is an example (commented out) that uses
 	// 10% instead; to use this, comment out the existing else if statement, and change the 0.1f to the percentage
-	// you want to use (0.1f is 10%)
+	// you want to use (0.1f is 10%). GetChargeRegenEventValue must then return MaxCharge * 0.1f while drained, so
+	// regeneration gets materialized when crossing it
 	//
-	// else if (bChargeDrained && Charge >= MaxCharge * 0.1f)
+	// else if (bWasDrained && NewValue >= MaxCharge * 0.1f)
 	// {
-	// 	SetChargeDrained(false);
+	// 	return false;
 	// }
-	else if (FMath::IsNearlyEqual(Charge, MaxCharge))
+	else if (FMath::IsNearlyEqual(NewValue, MaxCharge))
 	{
-		Charge = MaxCharge;
-		if (bChargeDrained)
-		{
-			SetChargeDrained(false);
-		}
+		return false;
 	}
+	return bWasDrained;
 }
 
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -1428,50 +2553,267 @@ void UXMUFoundationMovement::OnChargeChanged(float PrevValue, float NewValue)
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Networking stuff */
 
+namespace XMUFoundationCharacter
+{
+	/** Server side record of why clients got corrected and how far their resources were from the server ones */
+	struct FCorrectionTelemetry
+	{
+		enum EField { Stamina, Charge, CoyoteTime, NumFields };
+		/** Buckets of error / correction threshold: [0, 1/8), [1/8, 1/4), ..., [4, 8), [8, inf) */
+		static constexpr int32 NumErrorBuckets = 8;
+
+		int32 NumChecks = 0;
+		int32 NumPositionCorrections = 0;
+		int32 NumChecksumCorrections = 0;
+		int32 NumResourceOnlyCorrections = 0;
+		int32 NumFieldCorrections[NumFields] = {};
+		int32 ErrorHistogram[NumFields][NumErrorBuckets] = {};
+		float MaxError[NumFields] = {};
+
+		void RecordError(EField Field, float Error, float Threshold)
+		{
+			const float Ratio = Threshold > 0.f ? Error / Threshold : (Error > 0.f ? UE_BIG_NUMBER : 0.f);
+			const int32 Bucket = Ratio < 0.125f ? 0 : FMath::Clamp(FMath::FloorToInt(FMath::Log2(Ratio)) + 4, 0, NumErrorBuckets - 1);
+			++ErrorHistogram[Field][Bucket];
+			MaxError[Field] = FMath::Max(MaxError[Field], Error);
+		}
+
+		void Dump(FOutputDevice& Ar) const
+		{
+			static const TCHAR* FieldNames[NumFields] = { TEXT("Stamina"), TEXT("Charge"), TEXT("CoyoteTime") };
+			static const TCHAR* BucketNames[NumErrorBuckets] = { TEXT("<1/8"), TEXT("1/8-1/4"), TEXT("1/4-1/2"), TEXT("1/2-1"), TEXT("1-2"), TEXT("2-4"), TEXT("4-8"), TEXT(">8") };
+
+			Ar.Logf(TEXT("XMU client corrections over %d checks:"), NumChecks);
+			Ar.Logf(TEXT("  Position: %d"), NumPositionCorrections);
+			Ar.Logf(TEXT("  Resource checksum: %d"), NumChecksumCorrections);
+			for (int32 Field = 0; Field < NumFields; ++Field)
+			{
+				Ar.Logf(TEXT("  %s: %d"), FieldNames[Field], NumFieldCorrections[Field]);
+			}
+			Ar.Logf(TEXT("  Sent as resource-only corrections: %d"), NumResourceOnlyCorrections);
+
+			Ar.Logf(TEXT("Resource error distribution (error / correction threshold):"));
+			for (int32 Field = 0; Field < NumFields; ++Field)
+			{
+				FString Line = FString::Printf(TEXT("  %-10s max %8.4f |"), FieldNames[Field], MaxError[Field]);
+				for (int32 Bucket = 0; Bucket < NumErrorBuckets; ++Bucket)
+				{
+					Line += FString::Printf(TEXT(" %s: %d"), BucketNames[Bucket], ErrorHistogram[Field][Bucket]);
+				}
+				Ar.Log(Line);
+			}
+		}
+	};
+	static FCorrectionTelemetry CorrectionTelemetry;
+
+	static FAutoConsoleCommandWithOutputDevice DumpCorrectionStatsCommand(
+		TEXT("XMU.DumpCorrectionStats"),
+		TEXT("Prints the client correction causes and the resource error distribution recorded by this server."),
+		FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar) { CorrectionTelemetry.Dump(Ar); }));
+
+	static FAutoConsoleCommand ResetCorrectionStatsCommand(
+		TEXT("XMU.ResetCorrectionStats"),
+		TEXT("Clears the client correction stats recorded by this server."),
+		FConsoleCommandDelegate::CreateLambda([]() { CorrectionTelemetry = FCorrectionTelemetry(); }));
+}
+
 bool UXMUFoundationMovement::ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel,
 	const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementFoundation,
 	FName ClientFoundationBoneName, uint8 ClientMovementMode)
 {
+	++XMUFoundationCharacter::CorrectionTelemetry.NumChecks;
+	
 	if (Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientWorldLocation, RelativeClientLocation,
 		ClientMovementFoundation, ClientFoundationBoneName, ClientMovementMode))
 	{
+		++XMUFoundationCharacter::CorrectionTelemetry.NumPositionCorrections;
+		XMU_COUNT_STAT(CorrectionPosition);
 		return true;
 	}
 	
 	const FXMUFoundationNetworkMoveData* CurrentMoveData = static_cast<const FXMUFoundationNetworkMoveData*>(GetCurrentNetworkMoveData());
 
-	/*
-	GEngine->AddOnScreenDebugMessage(38262, 1.f, FColor::Orange, FString::Printf(TEXT("Delta Stamina From Regen Alone %f    "), DeltaTime*StaminaRegenRate));
-	GEngine->AddOnScreenDebugMessage(38263, 1.f, FColor::Orange, FString::Printf(TEXT("Error (Autonomous - Authority) %f    "), CurrentMoveData->Stamina - Stamina));
-	GEngine->AddOnScreenDebugMessage(38264, 1.f, FColor::Orange, FString::Printf(TEXT("[Authority] Stamina %f    "), Stamina));
-	GEngine->AddOnScreenDebugMessage(38265, 1.f, FColor::Orange, FString::Printf(TEXT("[Autonomous] Stamina %f    "), CurrentMoveData->Stamina));
+	if (ServerCheckClientResourceError(*CurrentMoveData))
+	{
+		if (bUseResourceOnlyCorrections)
+		{
+			// Position is fine, so we only send the resources instead of making the client replay all its moves
+			if (ServerSendResourceCorrection(ClientTimeStamp))
+			{
+				++XMUFoundationCharacter::CorrectionTelemetry.NumResourceOnlyCorrections;
+				XMU_COUNT_STAT(CorrectionResourceOnly);
+			}
+			return false;
+		}
+		return true;
+	}
+	
+	return false;
+}
+
+void UXMUFoundationMovement::CallServerMovePacked(const FSavedMove_Character* NewMove, const FSavedMove_Character* PendingMove, const FSavedMove_Character* OldMove)
+{
+	XMU_COUNT_STAT(ServerMoveRPC);
+	Super::CallServerMovePacked(NewMove, PendingMove, OldMove);
+}
 
-	if (FMath::Abs(CurrentMoveData->Stamina - Stamina) > NetworkStaminaCorrectionThreshold)
+bool UXMUFoundationMovement::ServerCheckClientResourceError(const FXMUFoundationNetworkMoveData& MoveData) const
+{
+	using namespace XMUFoundationCharacter;
+	
+	// The client only sent a checksum of its resources, the full values will be sent back only if it disagrees
+	if (bUseNetworkResourceChecksum)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Stamina error %f"), CurrentMoveData->Stamina - Stamina)
+		if (!MatchesNetworkResourceChecksum(MoveData.ResourceChecksum))
+		{
+			++CorrectionTelemetry.NumChecksumCorrections;
+			XMU_COUNT_STAT(CorrectionResourceChecksum);
+			return true;
+		}
+		return false;
 	}
-	*/
+
+	const float StaminaError = FMath::Abs(MoveData.Stamina - GetStamina());
+	const float ChargeError = FMath::Abs(MoveData.Charge - GetCharge());
+	const float CoyoteTimeError = FMath::Abs(MoveData.CoyoteTimeDuration - CoyoteTimeDuration);
+	CorrectionTelemetry.RecordError(FCorrectionTelemetry::Stamina, StaminaError, NetworkStaminaCorrectionThreshold);
+	CorrectionTelemetry.RecordError(FCorrectionTelemetry::Charge, ChargeError, NetworkChargeCorrectionThreshold);
+	CorrectionTelemetry.RecordError(FCorrectionTelemetry::CoyoteTime, CoyoteTimeError, NetworkCoyoteTimeDurationCorrectionThreshold);
+	CSV_CUSTOM_STAT(XMUMovement, StaminaError, StaminaError, ECsvCustomStatOp::Max);
+	CSV_CUSTOM_STAT(XMUMovement, ChargeError, ChargeError, ECsvCustomStatOp::Max);
+	CSV_CUSTOM_STAT(XMUMovement, CoyoteTimeError, CoyoteTimeError, ECsvCustomStatOp::Max);
+
+	bool bError = false;
 	
 	// This will trigger a client correction if the Stamina value in the Client differs NetworkStaminaCorrectionThreshold (2.f default) units from the one in the server
 	// Desyncs can happen if we set the Stamina directly in Gameplay code (ie: GAS)
-	if (!FMath::IsNearlyEqual(CurrentMoveData->Stamina, Stamina, NetworkStaminaCorrectionThreshold))
+	if (StaminaError > NetworkStaminaCorrectionThreshold)
 	{
-		return true;
+		++CorrectionTelemetry.NumFieldCorrections[FCorrectionTelemetry::Stamina];
+		XMU_COUNT_STAT(CorrectionStamina);
+		bError = true;
 	}
 	// This will trigger a client correction if the Charge value in the Client differs NetworkChargeCorrectionThreshold (2.f default) units from the one in the server
 	// Desyncs can happen if we set the Charge directly in Gameplay code (ie: GAS)
-	if (!FMath::IsNearlyEqual(CurrentMoveData->Charge, Charge, NetworkChargeCorrectionThreshold))
+	if (ChargeError > NetworkChargeCorrectionThreshold)
 	{
-		return true;
+		++CorrectionTelemetry.NumFieldCorrections[FCorrectionTelemetry::Charge];
+		XMU_COUNT_STAT(CorrectionCharge);
+		bError = true;
 	}
 
 	// This will trigger a client correction if the CoyoteTimeDuration value in the Client differs NetworkCoyoteTimeDurationCorrectionThreshold (2.f default) units from the one in the server
-	if (!FMath::IsNearlyEqual(CurrentMoveData->CoyoteTimeDuration, CoyoteTimeDuration, NetworkCoyoteTimeDurationCorrectionThreshold))
+	if (CoyoteTimeError > NetworkCoyoteTimeDurationCorrectionThreshold)
 	{
-		return true;
+		++CorrectionTelemetry.NumFieldCorrections[FCorrectionTelemetry::CoyoteTime];
+		XMU_COUNT_STAT(CorrectionCoyoteTime);
+		bError = true;
 	}
     
-	return false;
+	return bError;
+}
+
+bool UXMUFoundationMovement::ServerSendResourceCorrection(float ClientTimeStamp)
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+	if (CurrentTime - ServerLastResourceCorrectionTime < NetworkMinTimeBetweenResourceCorrections)
+	{
+		return false;
+	}
+	ServerLastResourceCorrectionTime = CurrentTime;
+
+	FXMUResourceCorrection Correction;
+	Correction.TimeStamp = ClientTimeStamp;
+	Correction.Stamina = GetStamina();
+	Correction.bStaminaDrained = IsStaminaDrained();
+	Correction.Charge = GetCharge();
+	Correction.bChargeDrained = IsChargeDrained();
+	Correction.CoyoteTimeDuration = GetCoyoteTimeDuration();
+	ClientAdjustResources(Correction);
+	return true;
+}
+
+void UXMUFoundationMovement::ClientAdjustResources_Implementation(const FXMUResourceCorrection& Correction)
+{
+	if (!HasValidData() || !IsActive())
+	{
+		return;
+	}
+
+	FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character();
+	check(ClientData);
+
+	// Find the corrected move by its exact time stamp like ClientAdjustPosition does: ordering time stamps doesn't work
+	// across a time stamp reset (see MinTimeBetweenTimeStampResets), the moves made before it are flagged instead
+	const FSavedMove_Character* CorrectedMove = nullptr;
+	int32 FirstMoveIndex = INDEX_NONE;
+	if (ClientData->LastAckedMove.IsValid() && ClientData->LastAckedMove->TimeStamp == Correction.TimeStamp)
+	{
+		CorrectedMove = ClientData->LastAckedMove.Get();
+		FirstMoveIndex = 0;
+	}
+	else
+	{
+		const int32 MoveIndex = ClientData->GetSavedMoveIndex(Correction.TimeStamp);
+		if (MoveIndex != INDEX_NONE)
+		{
+			CorrectedMove = ClientData->SavedMoves[MoveIndex].Get();
+			FirstMoveIndex = MoveIndex + 1;
+		}
+	}
+
+	// Moves acked after this correction are gone, so we would not be able to re-apply their deltas. A correction from
+	// before the last time stamp reset is dropped as well, the server sends a new one if we are still off
+	if (!CorrectedMove || CorrectedMove->bOldTimeStampBeforeReset)
+	{
+		return;
+	}
+
+	float NewStamina = Correction.Stamina;
+	bool bNewStaminaDrained = Correction.bStaminaDrained;
+	float NewCharge = Correction.Charge;
+	bool bNewChargeDrained = Correction.bChargeDrained;
+	float NewCoyoteTimeDuration = Correction.CoyoteTimeDuration;
+
+	// Re-apply what every move made after the corrected one did to the resources, without replaying movement
+	for (int32 MoveIndex = FirstMoveIndex; MoveIndex < ClientData->SavedMoves.Num(); ++MoveIndex)
+	{
+		FXMUSavedMove_Character_Foundation* FoundationMove = static_cast<FXMUSavedMove_Character_Foundation*>(ClientData->SavedMoves[MoveIndex].Get());
+
+		// The drain state can flip along the way (ie: the corrected Stamina runs out one move earlier). The moves keep
+		// the movement they already simulated, if it differs the server will send a full correction for it
+		const float StaminaDelta = FoundationMove->SavedStamina - FoundationMove->StartStamina;
+		FoundationMove->StartStamina = NewStamina;
+		FoundationMove->bStaminaDrained = bNewStaminaDrained;
+		NewStamina = FMath::Clamp(NewStamina + StaminaDelta, 0.f, MaxStamina);
+		if (!FMath::IsNearlyEqual(FoundationMove->StartStamina, NewStamina))
+		{
+			bNewStaminaDrained = GetStaminaDrainedAfterChange(NewStamina, bNewStaminaDrained);
+		}
+		FoundationMove->SavedStamina = NewStamina;
+
+		const float ChargeDelta = FoundationMove->SavedCharge - FoundationMove->StartCharge;
+		FoundationMove->StartCharge = NewCharge;
+		FoundationMove->bChargeDrained = bNewChargeDrained;
+		NewCharge = FMath::Clamp(NewCharge + ChargeDelta, 0.f, MaxCharge);
+		if (!FMath::IsNearlyEqual(FoundationMove->StartCharge, NewCharge))
+		{
+			bNewChargeDrained = GetChargeDrainedAfterChange(NewCharge, bNewChargeDrained);
+		}
+		FoundationMove->SavedCharge = NewCharge;
+
+		const float CoyoteTimeDelta = FoundationMove->SavedCoyoteTimeDuration - FoundationMove->StartCoyoteTimeDuration;
+		FoundationMove->StartCoyoteTimeDuration = NewCoyoteTimeDuration;
+		NewCoyoteTimeDuration = FMath::Clamp(NewCoyoteTimeDuration + CoyoteTimeDelta, 0.f, MaxCoyoteTimeDuration);
+		FoundationMove->SavedCoyoteTimeDuration = NewCoyoteTimeDuration;
+	}
+
+	SetStaminaDrained(bNewStaminaDrained);
+	SetStamina(NewStamina);
+	SetChargeDrained(bNewChargeDrained);
+	SetCharge(NewCharge);
+
+	SetCoyoteTimeDuration(NewCoyoteTimeDuration);
 }
 
 void UXMUFoundationMovement::OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp,
@@ -1496,8 +2838,38 @@ bool UXMUFoundationMovement::ClientUpdatePositionAfterServerUpdate()
 {
 	const bool bRealARMTFinishedLastFrame = AnimRootMotionTransition.bFinishedLastFrame;
 	const bool bRealRMSTFinishedLastFrame = RootMotionSourceTransition.bFinishedLastFrame;
+
+	const FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character();
+	const int32 NumReplayedMoves = (ClientData && ClientData->bUpdatePosition) ? ClientData->SavedMoves.Num() : 0;
+	const double ReplayStartTime = FPlatformTime::Seconds();
 	
-	const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
+	bool bResult;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_XMUReplay);
+		// The headroom cache is keyed on an exact simulation time, which replayed moves reuse. Its last sweep was made
+		// frames ago, so don't let the replayed last move pick it up
+		if (NumReplayedMoves > 0)
+		{
+			bHeadroomCacheValid = false;
+		}
+		ReplayQueryCache.Begin();
+		bResult = Super::ClientUpdatePositionAfterServerUpdate();
+		ReplayQueryCache.End();
+	}
+
+	if (NumReplayedMoves > 0)
+	{
+		const float ReplayTimeMs = static_cast<float>((FPlatformTime::Seconds() - ReplayStartTime) * 1000.0);
+		XMU_COUNT_STAT(ReplayCount);
+		INC_DWORD_STAT_BY(STAT_XMUReplayedMoves, NumReplayedMoves);
+		INC_DWORD_STAT_BY(STAT_XMUReplayQueryCacheHit, ReplayQueryCache.NumHits);
+		INC_DWORD_STAT_BY(STAT_XMUReplayQueryCacheMiss, ReplayQueryCache.NumMisses);
+		SET_FLOAT_STAT(STAT_XMUReplayTimeMs, ReplayTimeMs);
+		CSV_CUSTOM_STAT(XMUMovement, ReplayedMoves, NumReplayedMoves, ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(XMUMovement, ReplayTimeMs, ReplayTimeMs, ECsvCustomStatOp::Max);
+		CSV_CUSTOM_STAT(XMUMovement, ReplayQueryCacheHit, ReplayQueryCache.NumHits, ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(XMUMovement, ReplayQueryCacheMiss, ReplayQueryCache.NumMisses, ECsvCustomStatOp::Accumulate);
+	}
 
 	AnimRootMotionTransition.bFinishedLastFrame = bRealARMTFinishedLastFrame;
 	RootMotionSourceTransition.bFinishedLastFrame = bRealRMSTFinishedLastFrame;
@@ -1505,6 +2877,51 @@ bool UXMUFoundationMovement::ClientUpdatePositionAfterServerUpdate()
 	return bResult;
 }
 
+uint32 UXMUFoundationMovement::GetNetworkResourceChecksum(float InStamina, float InCharge, float InCoyoteTimeDuration) const
+{
+	return GetNetworkResourceChecksum(GetNetworkResourceChecksumSteps(InStamina, InCharge, InCoyoteTimeDuration));
+}
+
+bool UXMUFoundationMovement::MatchesNetworkResourceChecksum(uint32 ClientChecksum) const
+{
+	const FIntVector Steps = GetNetworkResourceChecksumSteps(GetStamina(), GetCharge(), CoyoteTimeDuration);
+	if (GetNetworkResourceChecksum(Steps) == ClientChecksum)
+	{
+		return true;
+	}
+
+	// Values close to a step boundary can end up one step away from the client one
+	for (int32 StaminaOffset = -1; StaminaOffset <= 1; ++StaminaOffset)
+	{
+		for (int32 ChargeOffset = -1; ChargeOffset <= 1; ++ChargeOffset)
+		{
+			for (int32 CoyoteTimeOffset = -1; CoyoteTimeOffset <= 1; ++CoyoteTimeOffset)
+			{
+				if (GetNetworkResourceChecksum(Steps + FIntVector(StaminaOffset, ChargeOffset, CoyoteTimeOffset)) == ClientChecksum)
+				{
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+uint32 UXMUFoundationMovement::GetNetworkResourceChecksum(const FIntVector& Steps) const
+{
+	const int32 Values[3] = { Steps.X, Steps.Y, Steps.Z };
+	return FCrc::MemCrc32(Values, sizeof(Values)) & ((1u << GetNetworkResourceChecksumBits()) - 1);
+}
+
+FIntVector UXMUFoundationMovement::GetNetworkResourceChecksumSteps(float InStamina, float InCharge, float InCoyoteTimeDuration) const
+{
+	// Steps are half the correction threshold: two values one step apart are always within the threshold
+	return FIntVector(
+		FMath::RoundToInt(InStamina / FMath::Max(0.5f * NetworkStaminaCorrectionThreshold, UE_KINDA_SMALL_NUMBER)),
+		FMath::RoundToInt(InCharge / FMath::Max(0.5f * NetworkChargeCorrectionThreshold, UE_KINDA_SMALL_NUMBER)),
+		FMath::RoundToInt(InCoyoteTimeDuration / FMath::Max(0.5f * NetworkCoyoteTimeDurationCorrectionThreshold, UE_KINDA_SMALL_NUMBER)));
+}
+
 void UXMUFoundationMovement::UpdateFromFoundationCompressedFlags()
 {
 	const FXMUFoundationNetworkMoveData* CurrentMoveData = static_cast<const FXMUFoundationNetworkMoveData*>(GetCurrentNetworkMoveData());
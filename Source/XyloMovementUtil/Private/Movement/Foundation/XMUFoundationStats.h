@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("XyloMovementUtil"), STATGROUP_XMUMovement, STATCAT_Advanced);
+
+CSV_DECLARE_CATEGORY_EXTERN(XMUMovement);
+
+/** Increments the STAT_XMU<Name> counter stat and the <Name> column of the XMUMovement csv category.
+ * Used as a statement, like INC_DWORD_STAT: XMU_COUNT_STAT(Name); */
+#define XMU_COUNT_STAT(Name) \
+	do \
+	{ \
+		INC_DWORD_STAT(STAT_XMU##Name); \
+		CSV_CUSTOM_STAT(XMUMovement, Name, 1, ECsvCustomStatOp::Accumulate); \
+	} while (0)
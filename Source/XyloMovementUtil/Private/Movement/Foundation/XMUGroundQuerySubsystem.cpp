@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Movement/Foundation/XMUGroundQuerySubsystem.h"
+
+#include "Engine/World.h"
+#include "Movement/Foundation/XMUFoundationMovement.h"
+#include "Movement/Foundation/XMUFoundationStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Ground Query Batch"), STAT_XMUGroundQueryBatch, STATGROUP_XMUMovement);
+DECLARE_CYCLE_STAT(TEXT("Ground Query Subsystem Tick"), STAT_XMUGroundQuerySubsystemTick, STATGROUP_XMUMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Ground Queries"), STAT_XMUBatchedGroundQuery, STATGROUP_XMUMovement);
+
+namespace XMUGroundQuery
+{
+	static float BatchSortCellSize = 2048.f;
+	FAutoConsoleVariableRef CVar_BatchSortCellSize(TEXT("XMU.GroundQueryBatchSortCellSize"), BatchSortCellSize, TEXT("Size of the cells used to sort batched ground queries by area. 0 keeps the request order."), ECVF_Default);
+
+	static int64 GetSortKey(const FVector& Location)
+	{
+		const int64 CellX = FMath::FloorToInt64(Location.X / BatchSortCellSize) & 0xFFFFFFFF;
+		const int64 CellY = FMath::FloorToInt64(Location.Y / BatchSortCellSize) & 0xFFFFFFFF;
+		return (CellX << 32) | CellY;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ * UXMUGroundQuerySubsystem
+ */
+
+void UXMUGroundQuerySubsystem::RequestGroundTrace(FXMUGroundQueryRequest&& Request)
+{
+	PendingRequests.Add(MoveTemp(Request));
+}
+
+void UXMUGroundQuerySubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_XMUGroundQuerySubsystemTick);
+
+	FlushRequests();
+}
+
+TStatId UXMUGroundQuerySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UXMUGroundQuerySubsystem, STATGROUP_Tickables);
+}
+
+bool UXMUGroundQuerySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UXMUGroundQuerySubsystem::FlushRequests()
+{
+	if (PendingRequests.IsEmpty())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_XMUGroundQueryBatch);
+	CSV_SCOPED_TIMING_STAT(XMUMovement, GroundQueryBatch);
+
+	UWorld* World = GetWorld();
+	check(World);
+
+	if (XMUGroundQuery::BatchSortCellSize > 0.f)
+	{
+		PendingRequests.Sort([](const FXMUGroundQueryRequest& A, const FXMUGroundQueryRequest& B)
+		{
+			return XMUGroundQuery::GetSortKey(A.Start) < XMUGroundQuery::GetSortKey(B.Start);
+		});
+	}
+
+	for (const FXMUGroundQueryRequest& Request : PendingRequests)
+	{
+		UXMUFoundationMovement* MovementComponent = Request.MovementComponent.Get();
+		if (!MovementComponent)
+		{
+			continue;
+		}
+
+		FHitResult HitResult;
+		World->LineTraceSingleByChannel(HitResult, Request.Start, Request.End, Request.CollisionChannel, Request.QueryParams, Request.ResponseParams);
+		MovementComponent->ReceiveDeferredGroundHit(HitResult);
+	}
+
+	INC_DWORD_STAT_BY(STAT_XMUBatchedGroundQuery, PendingRequests.Num());
+	CSV_CUSTOM_STAT(XMUMovement, BatchedGroundQuery, PendingRequests.Num(), ECsvCustomStatOp::Accumulate);
+
+	PendingRequests.Reset();
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Movement/Foundation/XMUTransitionName.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ * FXMUTransitionNameRegistry
+ */
+
+FXMUTransitionNameRegistry& FXMUTransitionNameRegistry::Get()
+{
+	static FXMUTransitionNameRegistry Registry;
+	return Registry;
+}
+
+FXMUTransitionNameRegistry::FXMUTransitionNameRegistry()
+{
+	Names.Add(NAME_None);
+	NameToId.Add(NAME_None, 0);
+}
+
+uint16 FXMUTransitionNameRegistry::FindOrAdd(FName InName)
+{
+	if (const uint16* FoundId = NameToId.Find(InName))
+	{
+		return *FoundId;
+	}
+
+	if (!ensureMsgf(Names.Num() <= MAX_uint16, TEXT("Too many transition names registered, %s will be treated as None"), *InName.ToString()))
+	{
+		return 0;
+	}
+
+	const uint16 NewId = static_cast<uint16>(Names.Add(InName));
+	NameToId.Add(InName, NewId);
+	return NewId;
+}
+
+uint16 FXMUTransitionNameRegistry::Find(FName InName) const
+{
+	const uint16* FoundId = NameToId.Find(InName);
+	return FoundId ? *FoundId : 0;
+}
+
+FName FXMUTransitionNameRegistry::GetName(uint16 Id) const
+{
+	return Names.IsValidIndex(Id) ? Names[Id] : NAME_None;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ * FXMUTransitionName
+ */
+
+bool FXMUTransitionName::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 PackedId = Id;
+	Ar.SerializeIntPacked(PackedId);
+	if (Ar.IsLoading())
+	{
+		Id = static_cast<uint16>(PackedId);
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Movement/Foundation/XMUFoundationCharacter.h"
+#include "Movement/Foundation/XMUFoundationMovement.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace XMUAccelerationPredictorTest
+{
+	constexpr double MaxAcceleration = 2048.0;
+	constexpr int32 FrameRate = 60;
+
+	enum class EPhase : uint8
+	{
+		Turning,
+		Straight,
+		SharpTurn,
+		Num
+	};
+
+	const TCHAR* GetPhaseName(EPhase Phase)
+	{
+		switch (Phase)
+		{
+		case EPhase::Turning: return TEXT("turning");
+		case EPhase::Straight: return TEXT("straight");
+		default: return TEXT("sharp turn");
+		}
+	}
+
+	/** Scripted input: full acceleration turning at 180 deg/s, then straight, then a 90 deg switch */
+	EPhase GetPhase(double Time)
+	{
+		return Time < 1.5 ? EPhase::Turning : Time < 2.5 ? EPhase::Straight : EPhase::SharpTurn;
+	}
+
+	FVector GetScriptedAcceleration(double Time)
+	{
+		const double TurnedDegrees = 180.0 * FMath::Min(Time, 1.5);
+		const double Degrees = GetPhase(Time) == EPhase::SharpTurn ? TurnedDegrees + 90.0 : TurnedDegrees;
+		return FRotator(0.0, Degrees, 0.0).Vector() * MaxAcceleration;
+	}
+
+	struct FPhaseError
+	{
+		double PlainError = 0.0;
+		double PredictedError = 0.0;
+		int32 NumFrames = 0;
+
+		double GetMeanPlainError() const { return PlainError / FMath::Max(NumFrames, 1); }
+		double GetMeanPredictedError() const { return PredictedError / FMath::Max(NumFrames, 1); }
+	};
+
+	/**
+	 * Plays the scripted input on a simulated proxy receiving ReplicatedAcceleration every FramesPerSample frames and compares,
+	 * each frame, the plain path (hold the last received value) and the predictor to the real acceleration
+	 */
+	void MeasurePhaseErrors(int32 FramesPerSample, FPhaseError (&OutErrors)[static_cast<int32>(EPhase::Num)])
+	{
+		constexpr int32 NumFrames = 3 * FrameRate;
+		constexpr float BlendTime = 0.1f;
+		constexpr float MaxExtrapolationTime = 0.25f;
+		const float MaxAngularRate = FMath::DegreesToRadians(720.f);
+
+		FXMUAccelerationPredictor Predictor;
+		FVector Received = FVector::ZeroVector;
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const double Time = static_cast<double>(Frame) / FrameRate;
+			const FVector Acceleration = GetScriptedAcceleration(Time);
+			if (Frame % FramesPerSample == 0)
+			{
+				FXMUReplicatedAcceleration ReplicatedAcceleration;
+				ReplicatedAcceleration.Pack(Acceleration, MaxAcceleration);
+				Received = ReplicatedAcceleration.Unpack(MaxAcceleration);
+				Predictor.AddSample(Received, Time, Predictor.Predict(Time, BlendTime, MaxExtrapolationTime, MaxAngularRate));
+			}
+			const FVector Predicted = Predictor.Predict(Time, BlendTime, MaxExtrapolationTime, MaxAngularRate);
+
+			FPhaseError& PhaseError = OutErrors[static_cast<int32>(GetPhase(Time))];
+			PhaseError.PlainError += FVector::Dist(Received, Acceleration);
+			PhaseError.PredictedError += FVector::Dist(Predicted, Acceleration);
+			++PhaseError.NumFrames;
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FXMUAccelerationPredictorTest, "XyloMovementUtil.Foundation.AccelerationPredictor", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FXMUAccelerationPredictorTest::RunTest(const FString& Parameters)
+{
+	using namespace XMUAccelerationPredictorTest;
+
+	// Lower send rates trade bandwidth for error, the predictor should win most of it back while turning
+	constexpr int32 BitsPerSample = 24;
+	for (const int32 FramesPerSample : { 3, 6, 12 })
+	{
+		FPhaseError Errors[static_cast<int32>(EPhase::Num)];
+		MeasurePhaseErrors(FramesPerSample, Errors);
+
+		const float SendRate = static_cast<float>(FrameRate) / FramesPerSample;
+		for (int32 PhaseIndex = 0; PhaseIndex < UE_ARRAY_COUNT(Errors); ++PhaseIndex)
+		{
+			AddInfo(FString::Printf(TEXT("%.0f Hz (%.0f bits/s), %s: mean error %.1f plain, %.1f predicted"), SendRate, SendRate * BitsPerSample,
+				GetPhaseName(static_cast<EPhase>(PhaseIndex)), Errors[PhaseIndex].GetMeanPlainError(), Errors[PhaseIndex].GetMeanPredictedError()));
+		}
+
+		const FPhaseError& Turning = Errors[static_cast<int32>(EPhase::Turning)];
+		TestTrue(FString::Printf(TEXT("Predictor beats the plain path while turning at %.0f Hz"), SendRate), Turning.GetMeanPredictedError() < Turning.GetMeanPlainError());
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+#include "XMUTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace XMUIdleSleepTest
+{
+	constexpr int32 NumCharacters = 200;
+	constexpr float DeltaTime = 1.f / 60.f;
+
+	/** Ticks the world NumFrames times and returns the average cost of a frame in milliseconds */
+	double MeasureFrameTime(const FXMUTestWorld& TestWorld, int32 NumFrames)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		TestWorld.Tick(DeltaTime, NumFrames);
+		return (FPlatformTime::Seconds() - StartTime) * 1000.0 / NumFrames;
+	}
+
+	int32 CountSleeping(const TArray<AXMUFoundationCharacter*>& Characters)
+	{
+		int32 NumSleeping = 0;
+		for (const AXMUFoundationCharacter* Character : Characters)
+		{
+			NumSleeping += Character->GetFoundationMovement()->IsIdleSleeping() ? 1 : 0;
+		}
+		return NumSleeping;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FXMUIdleSleepTest, "XyloMovementUtil.Foundation.IdleSleep", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FXMUIdleSleepTest::RunTest(const FString& Parameters)
+{
+	using namespace XMUIdleSleepTest;
+
+	constexpr int32 NumMeasuredFrames = 120;
+
+	// Idle crowd on a grid, far enough apart to not touch each other
+	FXMUTestWorld TestWorld;
+	TArray<AXMUFoundationCharacter*> Characters;
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters)));
+	for (int32 Index = 0; Index < NumCharacters; ++Index)
+	{
+		Characters.Add(TestWorld.SpawnCharacter(FVector2D(Index % GridSize, Index / GridSize) * 200.f));
+	}
+	TestWorld.Tick(DeltaTime, 60);
+
+	// Every character ticks its whole movement while awake
+	const double AwakeFrameTime = MeasureFrameTime(TestWorld, NumMeasuredFrames);
+	TestEqual(TEXT("Nobody sleeps without bEnableIdleSleep"), CountSleeping(Characters), 0);
+
+	for (AXMUFoundationCharacter* Character : Characters)
+	{
+		FXMUTestWorld::SetPropertyValue(Character->GetFoundationMovement(), TEXT("bEnableIdleSleep"), true);
+	}
+	TestWorld.Tick(DeltaTime, 60);
+	TestEqual(TEXT("Every idle character sleeps"), CountSleeping(Characters), NumCharacters);
+
+	const double SleepingFrameTime = MeasureFrameTime(TestWorld, NumMeasuredFrames);
+	AddInfo(FString::Printf(TEXT("%d idle characters: %.3f ms per frame awake, %.3f ms per frame sleeping"), NumCharacters, AwakeFrameTime, SleepingFrameTime));
+	TestEqual(TEXT("Sleeping characters stay asleep"), CountSleeping(Characters), NumCharacters);
+
+	// Input wakes the character up and it moves on the same frame
+	AXMUFoundationCharacter* MovedCharacter = Characters[0];
+	const FVector StartLocation = MovedCharacter->GetActorLocation();
+	MovedCharacter->AddMovementInput(FVector::ForwardVector);
+	TestWorld.Tick(DeltaTime);
+	TestFalse(TEXT("Input wakes the character up"), MovedCharacter->GetFoundationMovement()->IsIdleSleeping());
+	TestTrue(TEXT("Woken up character moved"), MovedCharacter->GetActorLocation().X > StartLocation.X);
+
+	// So does a resource that has to regenerate
+	UXMUFoundationMovement* RegenMoveComp = Characters[1]->GetFoundationMovement();
+	FXMUTestWorld::SetPropertyValue(RegenMoveComp, TEXT("StaminaRegenRate"), 10.f);
+	RegenMoveComp->SetStamina(RegenMoveComp->GetMaxStamina() * 0.5f);
+	TestWorld.Tick(DeltaTime);
+	TestFalse(TEXT("Regenerating stamina wakes the character up"), RegenMoveComp->IsIdleSleeping());
+	TestTrue(TEXT("Stamina regenerates once awake"), RegenMoveComp->GetStamina() > RegenMoveComp->GetMaxStamina() * 0.5f);
+
+	TestEqual(TEXT("The others keep sleeping"), CountSleeping(Characters), NumCharacters - 2);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "XMUTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace XMUMoveCombiningTest
+{
+	struct FScenarioResult
+	{
+		int32 NumMoves = 0;
+		int32 NumCombined = 0;
+		// Combined moves where the pending one was still transitioning and the new one was not
+		int32 NumCombinedAcrossTransitionEnd = 0;
+		int32 NumServerMoveRPCs = 0;
+	};
+
+	/**
+	 * Client saving moves at 120 Hz and sending them at most every 1/30 s while the end of an uncrouch transition
+	 * goes by, following ReplicateMoveToServer: a new move is combined with the pending one when possible, then held
+	 * back as the pending move if the last send is too recent.
+	 */
+	FScenarioResult RunUnCrouchScenario(AXMUFoundationCharacter& Character, bool bRelaxedMoveCombining)
+	{
+		IConsoleVariable* RelaxedMoveCombining = IConsoleManager::Get().FindConsoleVariable(TEXT("XMU.RelaxedMoveCombining"));
+		const int32 PrevRelaxedMoveCombining = RelaxedMoveCombining->GetInt();
+		RelaxedMoveCombining->Set(bRelaxedMoveCombining ? 1 : 0, ECVF_SetByCode);
+
+		constexpr float DeltaTime = 1.f / 120.f;
+		constexpr float NetMoveDelta = 1.f / 30.f;
+		constexpr float UnCrouchEndTime = 0.2f;
+		constexpr int32 NumMoves = 60;
+
+		UXMUFoundationMovement* MoveComp = Character.GetFoundationMovement();
+		FXMUNetworkPredictionData_Client_Character_Foundation ClientData(*MoveComp);
+
+		// BeginUnCrouch already resized the capsule, what is left is the transition timer
+		Character.bIsCrouched = false;
+		MoveComp->SetCrouchTransitioning(true);
+
+		FScenarioResult Result;
+		FSavedMovePtr PendingMove;
+		float Time = 0.f;
+		float LastSendTime = 0.f;
+		for (int32 MoveIndex = 0; MoveIndex < NumMoves; ++MoveIndex)
+		{
+			ClientData.CurrentTimeStamp = Time + DeltaTime;
+			FSavedMovePtr NewMove = ClientData.CreateSavedMove();
+			NewMove->SetMoveFor(&Character, DeltaTime, FVector::ZeroVector, ClientData);
+			++Result.NumMoves;
+
+			if (PendingMove.IsValid() && PendingMove->CanCombineWith(NewMove, &Character, ClientData.MaxMoveDeltaTime))
+			{
+				// The combined move is simulated again from the start of the pending one
+				FXMUSavedMove_Character_Foundation* FoundationNewMove = static_cast<FXMUSavedMove_Character_Foundation*>(NewMove.Get());
+				const FXMUSavedMove_Character_Foundation* FoundationPendingMove = static_cast<const FXMUSavedMove_Character_Foundation*>(PendingMove.Get());
+				if (FoundationPendingMove->bCrouchTransitioning && !FoundationNewMove->bCrouchTransitioning)
+				{
+					++Result.NumCombinedAcrossTransitionEnd;
+				}
+				FoundationNewMove->DeltaTime += FoundationPendingMove->DeltaTime;
+				FoundationNewMove->bCrouchTransitioning = FoundationPendingMove->bCrouchTransitioning;
+				MoveComp->SetCrouchTransitioning(FoundationPendingMove->bCrouchTransitioning);
+				ClientData.FreeMove(PendingMove);
+				PendingMove.Reset();
+				++Result.NumCombined;
+			}
+
+			// Movement: the transition ends on its own once enough time went by
+			Time += DeltaTime;
+			MoveComp->SetCrouchTransitioning(Time < UnCrouchEndTime);
+			NewMove->PostUpdate(&Character, FSavedMove_Character::PostUpdate_Record);
+
+			if (!PendingMove.IsValid() && Time - LastSendTime < NetMoveDelta - UE_KINDA_SMALL_NUMBER)
+			{
+				PendingMove = NewMove;
+				continue;
+			}
+
+			// Pending and new move go out in the same ServerMove
+			++Result.NumServerMoveRPCs;
+			LastSendTime = Time;
+			if (PendingMove.IsValid())
+			{
+				ClientData.FreeMove(PendingMove);
+				PendingMove.Reset();
+			}
+			ClientData.FreeMove(NewMove);
+		}
+
+		RelaxedMoveCombining->Set(PrevRelaxedMoveCombining, ECVF_SetByCode);
+		return Result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FXMUMoveCombiningTest, "XyloMovementUtil.Foundation.MoveCombining", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FXMUMoveCombiningTest::RunTest(const FString& Parameters)
+{
+	using namespace XMUMoveCombiningTest;
+
+	FXMUTestWorld TestWorld;
+	AXMUFoundationCharacter* Character = TestWorld.SpawnCharacter(FVector2D::ZeroVector);
+	TestWorld.Tick(1.f / 60.f, 30);
+	TestTrue(TEXT("Character landed"), Character->GetCharacterMovement()->IsMovingOnGround());
+
+	const FScenarioResult Strict = RunUnCrouchScenario(*Character, false);
+	const FScenarioResult Relaxed = RunUnCrouchScenario(*Character, true);
+	for (const FScenarioResult* Result : { &Strict, &Relaxed })
+	{
+		AddInfo(FString::Printf(TEXT("%s combining: %d / %d moves combined (%.0f%%), %d moves sent in %d ServerMove RPCs"),
+			Result == &Strict ? TEXT("Strict") : TEXT("Relaxed"), Result->NumCombined, Result->NumMoves,
+			100.f * Result->NumCombined / FMath::Max(Result->NumMoves, 1), Result->NumMoves - Result->NumCombined, Result->NumServerMoveRPCs));
+	}
+
+	TestEqual(TEXT("Strict combining keeps the uncrouch end apart"), Strict.NumCombinedAcrossTransitionEnd, 0);
+	TestTrue(TEXT("Relaxed combining merges across the uncrouch end"), Relaxed.NumCombinedAcrossTransitionEnd > 0);
+	TestTrue(TEXT("Relaxed combining sends fewer moves"), Relaxed.NumCombined > Strict.NumCombined);
+	TestTrue(TEXT("Relaxed combining doesn't send more ServerMove RPCs"), Relaxed.NumServerMoveRPCs <= Strict.NumServerMoveRPCs);
+
+	return true;
+}
+
+#endif
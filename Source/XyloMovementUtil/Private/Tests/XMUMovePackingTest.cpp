@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+#include "Movement/Foundation/XMUFoundationMovement.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace XMUMovePackingTest
+{
+	/** Fill used before saved moves were read by reference: a copy of the whole saved move per packed move */
+	struct FCopyingMoveData : public FXMUFoundationNetworkMoveData
+	{
+		virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override
+		{
+			FCharacterNetworkMoveData::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+			const FXMUSavedMove_Character_Foundation FoundationClientMove = static_cast<const FXMUSavedMove_Character_Foundation&>(ClientMove);
+			FoundationCompressedMoveFlags = FoundationClientMove.GetFoundationCompressedFlags();
+			Stamina = FoundationClientMove.SavedStamina;
+			Charge = FoundationClientMove.SavedCharge;
+			CoyoteTimeDuration = FoundationClientMove.SavedCoyoteTimeDuration;
+		}
+	};
+
+	/** Same layout as FXMUFoundationNetworkMoveDataContainer, with any move data type */
+	template<typename FMoveData>
+	struct TTestMoveDataContainer : public FCharacterNetworkMoveDataContainer
+	{
+		TTestMoveDataContainer()
+		{
+			NewMoveData = &MoveData[0];
+			PendingMoveData = &MoveData[1];
+			OldMoveData = &MoveData[2];
+
+			MoveData[1].DeltaBaseMoveData = &MoveData[0];
+			MoveData[2].DeltaBaseMoveData = &MoveData[0];
+		}
+
+		FMoveData MoveData[3];
+	};
+
+	void FillSavedMove(FXMUSavedMove_Character_Foundation& Move, float TimeStamp)
+	{
+		Move.TimeStamp = TimeStamp;
+		Move.DeltaTime = 1.f / 60.f;
+		Move.Acceleration = FVector(1200.f, 300.f, 0.f);
+		Move.SavedLocation = FVector(100.f * TimeStamp, 20.f, 90.f);
+		Move.SavedControlRotation = FRotator(-10.f, 30.f * TimeStamp, 0.f);
+		Move.StartStamina = 50.f - TimeStamp;
+		Move.SavedStamina = Move.StartStamina - 0.25f;
+		Move.StartCharge = 20.f + TimeStamp;
+		Move.SavedCharge = Move.StartCharge + 0.5f;
+		Move.StartCoyoteTimeDuration = 0.2f;
+		Move.SavedCoyoteTimeDuration = 0.18f;
+	}
+
+	/** Fills the New, Pending and Old entries from the saved moves and serializes them, like ServerMovePacked_ClientSend.
+	 * Returns the number of bits of the last packed cycle */
+	template<typename FContainer>
+	int64 MeasurePackingCycle(FAutomationTestBase& Test, const TCHAR* Name, UXMUFoundationMovement& MoveComp,
+		const FSavedMove_Character& NewMove, const FSavedMove_Character& PendingMove, const FSavedMove_Character& OldMove)
+	{
+		constexpr int32 NumCycles = 100000;
+		FContainer Container;
+		FBitWriter Writer(0, true);
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Cycle = 0; Cycle < NumCycles; ++Cycle)
+		{
+			Writer.Reset();
+			Container.ClientFillNetworkMoveData(&NewMove, &PendingMove, &OldMove);
+			Container.Serialize(MoveComp, Writer, nullptr);
+		}
+		const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+		Test.AddInfo(FString::Printf(TEXT("%s: %.1f ns per packing cycle (%lld bits)"), Name, ElapsedSeconds * 1.e9 / NumCycles, Writer.GetNumBits()));
+		return Writer.GetNumBits();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FXMUMovePackingTest, "XyloMovementUtil.Foundation.MovePacking", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FXMUMovePackingTest::RunTest(const FString& Parameters)
+{
+	using namespace XMUMovePackingTest;
+
+	UXMUFoundationMovement* MoveComp = NewObject<UXMUFoundationMovement>();
+
+	FXMUSavedMove_Character_Foundation OldMove;
+	FXMUSavedMove_Character_Foundation PendingMove;
+	FXMUSavedMove_Character_Foundation NewMove;
+	FillSavedMove(OldMove, 1.f);
+	FillSavedMove(PendingMove, 1.05f);
+	FillSavedMove(NewMove, 1.1f);
+
+	// Both fills must produce the same packet, only the cost differs
+	const int64 CopyingBits = MeasurePackingCycle<TTestMoveDataContainer<FCopyingMoveData>>(*this, TEXT("Copying fill"), *MoveComp, NewMove, PendingMove, OldMove);
+	const int64 ReferenceBits = MeasurePackingCycle<FXMUFoundationNetworkMoveDataContainer>(*this, TEXT("Reference fill"), *MoveComp, NewMove, PendingMove, OldMove);
+	TestEqual(TEXT("Same packet size"), ReferenceBits, CopyingBits);
+
+	// The packed moves read back as what was saved
+	FXMUFoundationNetworkMoveDataContainer Container;
+	Container.ClientFillNetworkMoveData(&NewMove, &PendingMove, &OldMove);
+	FBitWriter Writer(0, true);
+	Container.Serialize(*MoveComp, Writer, nullptr);
+
+	FXMUFoundationNetworkMoveDataContainer ReadContainer;
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	ReadContainer.Serialize(*MoveComp, Reader, nullptr);
+	TestFalse(TEXT("Read without error"), Reader.IsError());
+	TestTrue(TEXT("Has pending move"), ReadContainer.bHasPendingMove);
+	TestTrue(TEXT("Has old move"), ReadContainer.bHasOldMove);
+
+	const FXMUNetQuantizedRange StaminaRange = MoveComp->GetNetworkStaminaQuantization();
+	const FXMUNetQuantizedRange ChargeRange = MoveComp->GetNetworkChargeQuantization();
+	const FXMUFoundationNetworkMoveData* ReadMoves[] = {
+		static_cast<const FXMUFoundationNetworkMoveData*>(ReadContainer.GetNewMoveData()),
+		static_cast<const FXMUFoundationNetworkMoveData*>(ReadContainer.GetPendingMoveData()),
+		static_cast<const FXMUFoundationNetworkMoveData*>(ReadContainer.GetOldMoveData()) };
+	const FXMUSavedMove_Character_Foundation* SavedMoves[] = { &NewMove, &PendingMove, &OldMove };
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(ReadMoves); ++Index)
+	{
+		TestNearlyEqual(TEXT("Stamina"), ReadMoves[Index]->Stamina, SavedMoves[Index]->SavedStamina, StaminaRange.GetMaxError() + UE_KINDA_SMALL_NUMBER);
+		TestNearlyEqual(TEXT("Charge"), ReadMoves[Index]->Charge, SavedMoves[Index]->SavedCharge, ChargeRange.GetMaxError() + UE_KINDA_SMALL_NUMBER);
+	}
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+#include "Movement/Foundation/XMUNetQuantization.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace XMUPolarVectorQuantizationTest
+{
+	constexpr double Tolerance = 1.e-6;
+
+	/** Round trips Vector and checks every component against the codec's max errors (inputs out of range are expected
+	 * to come back clamped) */
+	template<typename FCodec>
+	bool TestRoundTrip(FAutomationTestBase& Test, const FVector& Vector, double MaxValue)
+	{
+		FCodec Codec;
+		Codec.Quantize(Vector, MaxValue);
+		const FVector Result = Codec.Dequantize(MaxValue);
+
+		bool bSuccess = Codec.Angle < FCodec::AngleSteps;
+
+		const double ExpectedMagnitude = FMath::Min(Vector.Size2D(), MaxValue);
+		bSuccess &= FMath::Abs(Result.Size2D() - ExpectedMagnitude) <= FCodec::GetMaxMagnitudeError(MaxValue) + Tolerance;
+
+		const double ExpectedZ = FMath::Clamp(Vector.Z, -MaxValue, MaxValue);
+		bSuccess &= FMath::Abs(Result.Z - ExpectedZ) <= FCodec::GetMaxZError(MaxValue) + Tolerance;
+
+		// A length that quantizes to 0 has no direction
+		if (Codec.Magnitude != 0)
+		{
+			const double DeltaRadians = FMath::FindDeltaAngleRadians(FMath::Atan2(Vector.Y, Vector.X), FMath::Atan2(Result.Y, Result.X));
+			bSuccess &= FMath::Abs(DeltaRadians) <= FCodec::GetMaxAngleError() + Tolerance;
+		}
+
+		if (!bSuccess)
+		{
+			Test.AddError(FString::Printf(TEXT("%s round trips to %s (max %f)"), *Vector.ToString(), *Result.ToString(), MaxValue));
+		}
+		return bSuccess;
+	}
+
+	template<typename FCodec>
+	void TestCodec(FAutomationTestBase& Test, double MaxValue)
+	{
+		// Angles over [-PI, PI], both ends included, with lengths and Z at and beyond the edges of the range
+		const double MinMagnitude = 3.0 * FCodec::GetMaxMagnitudeError(MaxValue);
+		const double Magnitudes[] = { MinMagnitude, 0.5 * MaxValue, MaxValue, 1.5 * MaxValue };
+		const double Zs[] = { -1.5 * MaxValue, -MaxValue, -0.5 * MaxValue, 0.0, 0.5 * MaxValue, MaxValue, 1.5 * MaxValue };
+		constexpr int32 NumAngles = 4096;
+		int32 NumFailed = 0;
+		for (int32 AngleIndex = 0; AngleIndex <= NumAngles; ++AngleIndex)
+		{
+			const double Radians = -UE_DOUBLE_PI + UE_DOUBLE_TWO_PI * AngleIndex / NumAngles;
+			for (const double Magnitude : Magnitudes)
+			{
+				for (const double Z : Zs)
+				{
+					FVector Vector(FVector::ZeroVector);
+					FMath::PolarToCartesian(Magnitude, Radians, Vector.X, Vector.Y);
+					Vector.Z = Z;
+					NumFailed += TestRoundTrip<FCodec>(Test, Vector, MaxValue) ? 0 : 1;
+				}
+			}
+		}
+		Test.TestEqual(TEXT("Failed round trips"), NumFailed, 0);
+
+		// -PI and +PI are the same direction and must land on the same step
+		FCodec MinusPi, PlusPi;
+		MinusPi.Quantize(FVector(-MaxValue, -UE_DOUBLE_SMALL_NUMBER, 0.0), MaxValue);
+		PlusPi.Quantize(FVector(-MaxValue, UE_DOUBLE_SMALL_NUMBER, 0.0), MaxValue);
+		Test.TestEqual(TEXT("-PI and +PI encode to the same angle"), int32(MinusPi.Angle), int32(PlusPi.Angle));
+		Test.TestEqual(TEXT("PI encodes to half a turn"), int32(PlusPi.Angle), int32(FCodec::AngleSteps / 2));
+
+		// Every encoded value decodes to something that encodes back to it
+		int32 NumUnstable = 0;
+		for (uint32 Angle = 0; Angle < FCodec::AngleSteps; ++Angle)
+		{
+			for (uint32 Magnitude = 1; Magnitude <= FCodec::MaxMagnitude; ++Magnitude)
+			{
+				FCodec Codec;
+				Codec.Angle = static_cast<uint16>(Angle);
+				Codec.Magnitude = static_cast<uint16>(Magnitude);
+				FCodec RoundTrip;
+				RoundTrip.Quantize(Codec.Dequantize(MaxValue), MaxValue);
+				NumUnstable += RoundTrip == Codec ? 0 : 1;
+			}
+		}
+		for (int32 Z = -FCodec::MaxZ; Z <= FCodec::MaxZ; ++Z)
+		{
+			FCodec Codec;
+			Codec.Z = static_cast<int16>(Z);
+			FCodec RoundTrip;
+			RoundTrip.Quantize(Codec.Dequantize(MaxValue), MaxValue);
+			NumUnstable += RoundTrip == Codec ? 0 : 1;
+		}
+		Test.TestEqual(TEXT("Encoded values not stable through a round trip"), NumUnstable, 0);
+	}
+
+	template<typename FCodec>
+	void MeasureThroughput(FAutomationTestBase& Test, const TCHAR* Name, double MaxValue)
+	{
+		constexpr int32 NumVectors = 1 << 20;
+		FVector Sum(FVector::ZeroVector);
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumVectors; ++Index)
+		{
+			FVector Vector(FVector::ZeroVector);
+			FMath::PolarToCartesian(MaxValue * (Index & 1023) / 1023.0, UE_DOUBLE_TWO_PI * (Index >> 10) / 1024.0, Vector.X, Vector.Y);
+			Vector.Z = MaxValue * ((Index & 255) - 128) / 128.0;
+			FCodec Codec;
+			Codec.Quantize(Vector, MaxValue);
+			Sum += Codec.Dequantize(MaxValue);
+		}
+		const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+		Test.AddInfo(FString::Printf(TEXT("%s: %.1f ns per quantize + dequantize (checksum %s)"), Name, ElapsedSeconds * 1.e9 / NumVectors, *Sum.ToString()));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FXMUPolarVectorQuantizationTest, "XyloMovementUtil.Foundation.PolarVectorQuantization", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FXMUPolarVectorQuantizationTest::RunTest(const FString& Parameters)
+{
+	using namespace XMUPolarVectorQuantizationTest;
+
+	// Layout of FXMUReplicatedAcceleration, and a wider one
+	TestCodec<TXMUQuantizedPolarVector<8, 8, 8>>(*this, 2048.0);
+	TestCodec<TXMUQuantizedPolarVector<12, 10, 10>>(*this, 2048.0);
+
+	MeasureThroughput<TXMUQuantizedPolarVector<8, 8, 8>>(*this, TEXT("8/8/8"), 2048.0);
+	MeasureThroughput<TXMUQuantizedPolarVector<12, 10, 10>>(*this, TEXT("12/10/10"), 2048.0);
+
+	return true;
+}
+
+#endif
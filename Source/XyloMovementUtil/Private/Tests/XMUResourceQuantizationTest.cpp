@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Movement/Foundation/XMUFoundationMovement.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace XMUResourceQuantizationTest
+{
+	struct FTestMoveData : public FXMUFoundationNetworkMoveData
+	{
+		/** Encoding used before the resources were quantized: raw optional floats */
+		bool SerializeRawResources(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, ENetworkMoveType MoveType)
+		{
+			FCharacterNetworkMoveData::Serialize(CharacterMovement, Ar, nullptr, MoveType);
+			SerializeOptionalValue<uint8>(Ar.IsSaving(), Ar, FoundationCompressedMoveFlags, 0);
+			SerializeOptionalValue<float>(Ar.IsSaving(), Ar, Stamina, 0.f);
+			SerializeOptionalValue<float>(Ar.IsSaving(), Ar, Charge, 0.f);
+			SerializeOptionalValue<float>(Ar.IsSaving(), Ar, CoyoteTimeDuration, 0.f);
+			return !Ar.IsError();
+		}
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FXMUResourceQuantizationTest, "XyloMovementUtil.Foundation.ResourceQuantization", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FXMUResourceQuantizationTest::RunTest(const FString& Parameters)
+{
+	using namespace XMUResourceQuantizationTest;
+
+	UXMUFoundationMovement* MoveComp = NewObject<UXMUFoundationMovement>();
+	const FXMUNetQuantizedRange StaminaRange = MoveComp->GetNetworkStaminaQuantization();
+	const FXMUNetQuantizedRange ChargeRange = MoveComp->GetNetworkChargeQuantization();
+	const FXMUNetQuantizedRange CoyoteTimeRange = MoveComp->GetNetworkCoyoteTimeDurationQuantization();
+
+	FTestMoveData MoveData;
+	MoveData.TimeStamp = 1.f;
+	MoveData.Acceleration = FVector(100.f, 50.f, 0.f);
+	MoveData.Location = FVector(10.f, 20.f, 30.f);
+	MoveData.Stamina = 37.3f;
+	MoveData.Charge = 81.9f;
+	MoveData.CoyoteTimeDuration = 0.17f;
+
+	FBitWriter RawWriter(0, true);
+	MoveData.SerializeRawResources(*MoveComp, RawWriter, ENetworkMoveType::NewMove);
+	FBitWriter QuantizedWriter(0, true);
+	MoveData.Serialize(*MoveComp, QuantizedWriter, nullptr, ENetworkMoveType::NewMove);
+
+	// Everything else is encoded the same way, each non zero resource goes from 1 + 32 bits to 1 + 1 (in range) + NumBits
+	const int64 ExpectedSavedBits = (31 - StaminaRange.NumBits) + (31 - ChargeRange.NumBits) + (31 - CoyoteTimeRange.NumBits);
+	TestEqual(TEXT("Default stamina bits"), int32(StaminaRange.NumBits), 10);
+	TestEqual(TEXT("Default charge bits"), int32(ChargeRange.NumBits), 10);
+	TestEqual(TEXT("Default coyote time bits"), int32(CoyoteTimeRange.NumBits), 8);
+	TestEqual(TEXT("Bits saved per move"), RawWriter.GetNumBits() - QuantizedWriter.GetNumBits(), ExpectedSavedBits);
+	AddInfo(FString::Printf(TEXT("New move: %lld bits raw, %lld bits quantized"), RawWriter.GetNumBits(), QuantizedWriter.GetNumBits()));
+
+	// The server reads values within the quantization error, which stays below the correction thresholds
+	FBitReader Reader(QuantizedWriter.GetData(), QuantizedWriter.GetNumBits());
+	FTestMoveData ReadMoveData;
+	ReadMoveData.Serialize(*MoveComp, Reader, nullptr, ENetworkMoveType::NewMove);
+	TestFalse(TEXT("Read without error"), Reader.IsError());
+	TestTrue(TEXT("Whole move consumed"), Reader.AtEnd());
+	TestNearlyEqual(TEXT("Stamina"), ReadMoveData.Stamina, MoveData.Stamina, StaminaRange.GetMaxError() + UE_KINDA_SMALL_NUMBER);
+	TestNearlyEqual(TEXT("Charge"), ReadMoveData.Charge, MoveData.Charge, ChargeRange.GetMaxError() + UE_KINDA_SMALL_NUMBER);
+	TestNearlyEqual(TEXT("CoyoteTimeDuration"), ReadMoveData.CoyoteTimeDuration, MoveData.CoyoteTimeDuration, CoyoteTimeRange.GetMaxError() + UE_KINDA_SMALL_NUMBER);
+
+	// The encoding only depends on class defaults, changing the max at runtime on one side must not change it
+	MoveComp->SetMaxStamina(MoveComp->GetMaxStamina() * 4.f);
+	MoveComp->SetMaxCharge(MoveComp->GetMaxCharge() * 4.f);
+	MoveComp->SetMaxCoyoteTimeDuration(MoveComp->GetMaxCoyoteTimeDuration() * 4.f);
+	TestEqual(TEXT("Runtime max doesn't change the stamina bits"), int32(MoveComp->GetNetworkStaminaQuantization().NumBits), int32(StaminaRange.NumBits));
+	TestEqual(TEXT("Runtime max doesn't change the stamina range"), MoveComp->GetNetworkStaminaQuantization().MaxValue, StaminaRange.MaxValue);
+
+	// Values above the old max escape the quantization and are read back exactly, so they don't cause corrections
+	FTestMoveData RaisedMoveData = MoveData;
+	RaisedMoveData.Stamina = StaminaRange.MaxValue * 3.f + 0.37f;
+	RaisedMoveData.Charge = ChargeRange.MaxValue * 2.f + 0.91f;
+	RaisedMoveData.CoyoteTimeDuration = CoyoteTimeRange.MaxValue * 1.5f;
+	TestEqual(TEXT("Values above the range are not snapped"), StaminaRange.Snap(RaisedMoveData.Stamina), RaisedMoveData.Stamina);
+
+	FBitWriter RaisedWriter(0, true);
+	RaisedMoveData.Serialize(*MoveComp, RaisedWriter, nullptr, ENetworkMoveType::NewMove);
+	FBitReader RaisedReader(RaisedWriter.GetData(), RaisedWriter.GetNumBits());
+	FTestMoveData ReadRaisedMoveData;
+	ReadRaisedMoveData.Serialize(*MoveComp, RaisedReader, nullptr, ENetworkMoveType::NewMove);
+	TestFalse(TEXT("Read raised values without error"), RaisedReader.IsError());
+	TestTrue(TEXT("Whole raised move consumed"), RaisedReader.AtEnd());
+	TestEqual(TEXT("Stamina above the old max"), ReadRaisedMoveData.Stamina, RaisedMoveData.Stamina);
+	TestEqual(TEXT("Charge above the old max"), ReadRaisedMoveData.Charge, RaisedMoveData.Charge);
+	TestEqual(TEXT("CoyoteTimeDuration above the old max"), ReadRaisedMoveData.CoyoteTimeDuration, RaisedMoveData.CoyoteTimeDuration);
+
+	// Pending and Old moves are delta encoded against the New move, the escape must work there too
+	FBitWriter DeltaWriter(0, true);
+	RaisedMoveData.Serialize(*MoveComp, DeltaWriter, nullptr, ENetworkMoveType::NewMove);
+	FTestMoveData PendingMoveData = RaisedMoveData;
+	PendingMoveData.Stamina = StaminaRange.MaxValue * 2.5f;
+	PendingMoveData.DeltaBaseMoveData = &RaisedMoveData;
+	PendingMoveData.Serialize(*MoveComp, DeltaWriter, nullptr, ENetworkMoveType::PendingMove);
+	FBitReader DeltaReader(DeltaWriter.GetData(), DeltaWriter.GetNumBits());
+	FTestMoveData ReadNewMoveData;
+	ReadNewMoveData.Serialize(*MoveComp, DeltaReader, nullptr, ENetworkMoveType::NewMove);
+	FTestMoveData ReadPendingMoveData;
+	ReadPendingMoveData.DeltaBaseMoveData = &ReadNewMoveData;
+	ReadPendingMoveData.Serialize(*MoveComp, DeltaReader, nullptr, ENetworkMoveType::PendingMove);
+	TestFalse(TEXT("Read delta encoded moves without error"), DeltaReader.IsError());
+	TestEqual(TEXT("Delta encoded stamina above the old max"), ReadPendingMoveData.Stamina, PendingMoveData.Stamina);
+
+	return true;
+}
+
+#endif
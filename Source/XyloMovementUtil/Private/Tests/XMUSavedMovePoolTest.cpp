@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Movement/Foundation/XMUFoundationMovement.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace XMUSavedMovePoolTest
+{
+	class FTestSavedMove : public FXMUSavedMove_Character_Foundation
+	{
+	};
+
+	/** Prediction data of a project subclass, counting every move it allocates */
+	class FCountingPredictionData : public FXMUNetworkPredictionData_Client_Character_Foundation
+	{
+	public:
+		using FXMUNetworkPredictionData_Client_Character_Foundation::FXMUNetworkPredictionData_Client_Character_Foundation;
+
+		virtual FSavedMovePtr AllocateNewMove() override
+		{
+			++NumAllocatedMoves;
+			return MakeShared<FTestSavedMove>();
+		}
+
+		int32 NumAllocatedMoves = 0;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FXMUSavedMovePoolTest, "XyloMovementUtil.Foundation.SavedMovePool", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FXMUSavedMovePoolTest::RunTest(const FString& Parameters)
+{
+	using namespace XMUSavedMovePoolTest;
+
+	FCountingPredictionData ClientData(*GetDefault<UXMUFoundationMovement>());
+	TestEqual(TEXT("No move is allocated on construction"), ClientData.NumAllocatedMoves, 0);
+
+	// The first move warms the pool up, through the subclass' AllocateNewMove
+	FSavedMovePtr FirstMove = ClientData.CreateSavedMove();
+	TestTrue(TEXT("First move is created"), FirstMove.IsValid());
+	const int32 NumWarmUpMoves = ClientData.NumAllocatedMoves;
+	TestEqual(TEXT("Warm up fills the free move pool"), NumWarmUpMoves, ClientData.MaxFreeMoveCount);
+	ClientData.FreeMove(FirstMove);
+	FirstMove.Reset();
+
+	// Steady state: moves are kept until the server acknowledges them, then freed. Every refill must hand out the
+	// same moves as the first fill, rather than new ones
+	const int32 NumOutstandingMoves = FMath::Min(ClientData.MaxSavedMoveCount, ClientData.MaxFreeMoveCount);
+	TSet<const FSavedMove_Character*> FirstFillMoves;
+	bool bReusedMoves = true;
+	for (int32 Cycle = 0; Cycle < 100; ++Cycle)
+	{
+		for (int32 MoveIndex = 0; MoveIndex < NumOutstandingMoves; ++MoveIndex)
+		{
+			const FSavedMovePtr& Move = ClientData.SavedMoves.Add_GetRef(ClientData.CreateSavedMove());
+			if (Cycle == 0)
+			{
+				FirstFillMoves.Add(Move.Get());
+			}
+			else
+			{
+				bReusedMoves &= FirstFillMoves.Contains(Move.Get());
+			}
+		}
+		for (const FSavedMovePtr& Move : ClientData.SavedMoves)
+		{
+			ClientData.FreeMove(Move);
+		}
+		ClientData.SavedMoves.Reset();
+	}
+	TestEqual(TEXT("First fill hands out distinct moves"), FirstFillMoves.Num(), NumOutstandingMoves);
+	TestTrue(TEXT("Refills reuse the moves of the first fill"), bReusedMoves);
+	TestEqual(TEXT("Recycling moves doesn't allocate"), ClientData.NumAllocatedMoves, NumWarmUpMoves);
+
+	return true;
+}
+
+#endif
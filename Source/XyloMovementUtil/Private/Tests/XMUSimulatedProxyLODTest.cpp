@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/AutomationTest.h"
+#include "XMUTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace XMUSimulatedProxyLODTest
+{
+	/** Only used to reach the protected ComputeSimulatedProxyLOD, never instantiated */
+	struct FLODAccess : public UXMUFoundationMovement
+	{
+		using UXMUFoundationMovement::ComputeSimulatedProxyLOD;
+	};
+
+	EXMUSimulatedProxyLOD ComputeLOD(const AXMUFoundationCharacter& Character)
+	{
+		return (Character.GetFoundationMovement()->*(&FLODAccess::ComputeSimulatedProxyLOD))();
+	}
+
+	/** Puts the local camera Distance away from the character, looking at it */
+	void PlaceCamera(APlayerCameraManager& CameraManager, const AXMUFoundationCharacter& Character, float Distance, float FOV)
+	{
+		FMinimalViewInfo POV;
+		POV.Location = Character.GetActorLocation() - FVector(Distance, 0.f, 0.f);
+		POV.Rotation = FRotator::ZeroRotator;
+		POV.FOV = FOV;
+		CameraManager.SetCameraCachePOV(POV);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FXMUSimulatedProxyLODTest, "XyloMovementUtil.Foundation.SimulatedProxyLOD", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FXMUSimulatedProxyLODTest::RunTest(const FString& Parameters)
+{
+	using namespace XMUSimulatedProxyLODTest;
+
+	FXMUTestWorld TestWorld;
+	AXMUFoundationCharacter* RenderedCharacter = TestWorld.SpawnCharacter(FVector2D::ZeroVector);
+	AXMUFoundationCharacter* HiddenCharacter = TestWorld.SpawnCharacter(FVector2D(0.f, 500.f));
+	TestWorld.Tick(1.f / 60.f, 30);
+
+	// Without a local camera there is nothing to reduce against
+	TestEqual(TEXT("No camera"), ComputeLOD(*RenderedCharacter), EXMUSimulatedProxyLOD::Full);
+
+	const APlayerController* PlayerController = TestWorld.GetWorld()->SpawnActor<APlayerController>();
+	APlayerCameraManager* CameraManager = PlayerController->PlayerCameraManager;
+	if (!TestNotNull(TEXT("Local camera"), CameraManager))
+	{
+		return false;
+	}
+	RenderedCharacter->GetCapsuleComponent()->SetLastRenderTime(TestWorld.GetWorld()->GetTimeSeconds());
+
+	// Tiers by distance, with the default 2500 / 6000 thresholds
+	PlaceCamera(*CameraManager, *RenderedCharacter, 1000.f, 60.f);
+	TestEqual(TEXT("Near"), ComputeLOD(*RenderedCharacter), EXMUSimulatedProxyLOD::Full);
+	PlaceCamera(*CameraManager, *RenderedCharacter, 4000.f, 60.f);
+	TestEqual(TEXT("Between near and far"), ComputeLOD(*RenderedCharacter), EXMUSimulatedProxyLOD::Reduced);
+	PlaceCamera(*CameraManager, *RenderedCharacter, 7000.f, 60.f);
+	TestEqual(TEXT("Beyond far"), ComputeLOD(*RenderedCharacter), EXMUSimulatedProxyLOD::Far);
+
+	// Close, but too small on screen through a very wide FOV
+	PlaceCamera(*CameraManager, *RenderedCharacter, 1000.f, 170.f);
+	TestEqual(TEXT("Below the min screen size"), ComputeLOD(*RenderedCharacter), EXMUSimulatedProxyLOD::Far);
+
+	// Close, but not recently rendered
+	PlaceCamera(*CameraManager, *HiddenCharacter, 1000.f, 60.f);
+	TestEqual(TEXT("Not recently rendered"), ComputeLOD(*HiddenCharacter), EXMUSimulatedProxyLOD::Far);
+
+	// Rendered too long ago (ticking updates the camera, so it's placed again after)
+	TestWorld.Tick(1.f / 60.f, 30);
+	PlaceCamera(*CameraManager, *RenderedCharacter, 1000.f, 60.f);
+	TestEqual(TEXT("Rendered too long ago"), ComputeLOD(*RenderedCharacter), EXMUSimulatedProxyLOD::Far);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Movement/Foundation/XMUFoundationCharacter.h"
+#include "Movement/Foundation/XMUFoundationMovement.h"
+#include "UObject/UnrealType.h"
+
+/**
+ * FXMUTestWorld
+ *
+ *	Standalone game world for movement tests, with a static floor whose top is at Z = 0. Only ticks when Tick is
+ *	called, and is destroyed with the object.
+ */
+class FXMUTestWorld
+{
+public:
+	FXMUTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("XMUTestWorld"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+
+		AActor* Floor = World->SpawnActor<AActor>();
+		UBoxComponent* FloorBox = NewObject<UBoxComponent>(Floor);
+		FloorBox->SetMobility(EComponentMobility::Static);
+		FloorBox->SetBoxExtent(FVector(100000.f, 100000.f, 10.f));
+		FloorBox->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+		Floor->SetRootComponent(FloorBox);
+		FloorBox->RegisterComponent();
+		FloorBox->SetWorldLocation(FVector(0.f, 0.f, -10.f));
+	}
+
+	~FXMUTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	UWorld* GetWorld() const { return World; }
+
+	/** Spawns a character standing on the floor. It has no controller, so its movement runs without one */
+	AXMUFoundationCharacter* SpawnCharacter(const FVector2D& Location) const
+	{
+		const float HalfHeight = GetDefault<AXMUFoundationCharacter>()->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+		AXMUFoundationCharacter* Character = World->SpawnActor<AXMUFoundationCharacter>(FVector(Location, HalfHeight + 1.f), FRotator::ZeroRotator);
+		Character->GetCharacterMovement()->bRunPhysicsWithNoController = true;
+		return Character;
+	}
+
+	void Tick(float DeltaTime, int32 NumTicks = 1) const
+	{
+		for (int32 TickIndex = 0; TickIndex < NumTicks; ++TickIndex)
+		{
+			World->Tick(LEVELTICK_All, DeltaTime);
+		}
+	}
+
+	/** Sets a property that tests can't reach otherwise (ie: protected movement settings) */
+	template<typename T>
+	static void SetPropertyValue(UObject* Object, FName PropertyName, const T& Value)
+	{
+		const FProperty* Property = FindFProperty<FProperty>(Object->GetClass(), PropertyName);
+		check(Property && Property->GetElementSize() == sizeof(T));
+		*Property->ContainerPtrToValuePtr<T>(Object) = Value;
+	}
+
+private:
+	UWorld* World = nullptr;
+};
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Movement/Foundation/XMUNetQuantization.h"
 #include "XMUFoundationCharacter.generated.h"
 
 
@@ -17,14 +18,40 @@ struct FXMUReplicatedAcceleration
 {
 	GENERATED_BODY()
 
+	using FCodec = TXMUQuantizedPolarVector<8, 8, 8>;
+
+	void Pack(const FVector& Acceleration, double MaxAcceleration)
+	{
+		FCodec Codec;
+		Codec.Quantize(Acceleration, MaxAcceleration);
+		AccelXYRadians = static_cast<uint8>(Codec.Angle);
+		AccelXYMagnitude = static_cast<uint8>(Codec.Magnitude);
+		AccelZ = static_cast<int8>(Codec.Z);
+	}
+
+	FVector Unpack(double MaxAcceleration) const
+	{
+		FCodec Codec;
+		Codec.Angle = AccelXYRadians;
+		Codec.Magnitude = AccelXYMagnitude;
+		Codec.Z = AccelZ;
+		return Codec.Dequantize(MaxAcceleration);
+	}
+
 	UPROPERTY()
-	uint8 AccelXYRadians = 0;	// Direction of XY accel component, quantized to represent [0, 2*pi]
+	uint8 AccelXYRadians = 0;	// Direction of XY accel component, quantized to represent [0, 2*pi)
 
 	UPROPERTY()
 	uint8 AccelXYMagnitude = 0;	//Accel rate of XY component, quantized to represent [0, MaxAcceleration]
 
 	UPROPERTY()
 	int8 AccelZ = 0;	// Raw Z accel rate component, quantized to represent [-MaxAcceleration, MaxAcceleration]
+
+	bool operator==(const FXMUReplicatedAcceleration& Other) const
+	{
+		return AccelXYRadians == Other.AccelXYRadians && AccelXYMagnitude == Other.AccelXYMagnitude && AccelZ == Other.AccelZ;
+	}
+	bool operator!=(const FXMUReplicatedAcceleration& Other) const { return !(*this == Other); }
 };
 
 
@@ -44,7 +71,6 @@ public:
 	
 public:
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
-	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 	/* Jump */
@@ -89,12 +115,18 @@ public:
 	UFUNCTION(BlueprintCallable)
 	virtual float GetGroundDistance();
 	
+public:
+	/** Quantizes Acceleration for simulated proxies, marking ReplicatedAcceleration dirty only if the quantized value
+	 * changed (push model) and at most once every MinSendInterval. Called by the movement component after each move on
+	 * the authority. */
+	void UpdateReplicatedAcceleration(const FVector& Acceleration, double MaxAcceleration, float MinSendInterval = 0.f);
 protected:
 	UFUNCTION()
 	void OnRep_ReplicatedAcceleration();
 private:
 	UPROPERTY(Transient, ReplicatedUsing = OnRep_ReplicatedAcceleration)
 	FXMUReplicatedAcceleration ReplicatedAcceleration;
+	double LastReplicatedAccelerationChangeTime = -UE_BIG_NUMBER;
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 	/* Jump */
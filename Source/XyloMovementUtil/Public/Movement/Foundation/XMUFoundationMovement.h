@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "WorldCollision.h"
+#include "Movement/Foundation/XMUNetQuantization.h"
+#include "Movement/Foundation/XMUTransitionName.h"
 #include "XMUFoundationMovement.generated.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -13,6 +16,7 @@
  */
 
 class AXMUFoundationCharacter;
+class APlayerCameraManager;
 
 struct XYLOMOVEMENTUTIL_API FXMUFoundationMoveResponseDataContainer : FCharacterMoveResponseDataContainer
 {
@@ -47,6 +51,8 @@ public:
 		, Stamina(0)
 		, Charge(0)
 		, CoyoteTimeDuration(0)
+		, ResourceChecksum(0)
+		, DeltaBaseMoveData(nullptr)
 	{
 	}
 
@@ -68,6 +74,13 @@ public:
 	float Charge;
 	
 	float CoyoteTimeDuration;
+
+	/** Sent instead of Stamina, Charge and CoyoteTimeDuration when UXMUFoundationMovement::UsesNetworkResourceChecksum */
+	uint32 ResourceChecksum;
+
+	/** Pending and Old moves encode their custom data relative to this move (the New move of the same container, which
+	 * is always serialized first) */
+	const FXMUFoundationNetworkMoveData* DeltaBaseMoveData;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -86,6 +99,9 @@ public:
 		NewMoveData = &MoveData[0];
 		PendingMoveData = &MoveData[1];
 		OldMoveData = &MoveData[2];
+
+		MoveData[1].DeltaBaseMoveData = &MoveData[0];
+		MoveData[2].DeltaBaseMoveData = &MoveData[0];
 	}
  
 private:
@@ -113,9 +129,7 @@ public:
 		, SavedCoyoteTimeDuration(0)
 		, CrouchProgress(0)
 		, bCrouchTransitioning(0)
-		, AnimRootMotionTransitionName("")
 		, bAnimRootMotionTransitionFinishedLastFrame(0)
-		, RootMotionSourceTransitionName("")
 		, bRootMotionSourceTransitionFinishedLastFrame(0)
 	{
 	}
@@ -136,9 +150,9 @@ public:
 	float CrouchProgress;
 	uint32 bCrouchTransitioning : 1;
 
-	FString AnimRootMotionTransitionName;
+	FXMUTransitionName AnimRootMotionTransitionName;
 	uint32 bAnimRootMotionTransitionFinishedLastFrame : 1;
-	FString RootMotionSourceTransitionName;
+	FXMUTransitionName RootMotionSourceTransitionName;
 	uint32 bRootMotionSourceTransitionFinishedLastFrame : 1;
 
 	/** Clear saved move properties, so it can be re-used. */
@@ -211,12 +225,34 @@ class XYLOMOVEMENTUTIL_API FXMUNetworkPredictionData_Client_Character_Foundation
 public:
 	FXMUNetworkPredictionData_Client_Character_Foundation(const UCharacterMovementComponent& ClientMovement)
 	: Super(ClientMovement)
-	{}
+	{
+	}
+
+	/** Fills the free move pool on the first call: CreateSavedMove pops from it and FreeMove pushes moves back, so once
+	 * warm a client tick recycles moves instead of allocating them. Done here rather than in the constructor so that
+	 * only characters that save moves pay for the pool, and so AllocateNewMove reaches the most derived override */
+	virtual FSavedMovePtr CreateSavedMove() override
+	{
+		if (!bFreeMovesWarmedUp)
+		{
+			bFreeMovesWarmedUp = true;
+			SavedMoves.Reserve(MaxSavedMoveCount);
+			FreeMoves.Reserve(MaxFreeMoveCount);
+			while (FreeMoves.Num() < MaxFreeMoveCount)
+			{
+				FreeMoves.Push(AllocateNewMove());
+			}
+		}
+		return Super::CreateSavedMove();
+	}
 
 	virtual FSavedMovePtr AllocateNewMove() override
 	{
 		return MakeShared<FXMUSavedMove_Character_Foundation>();
 	}
+
+private:
+	bool bFreeMovesWarmedUp = false;
 };
 
 
@@ -249,14 +285,14 @@ struct FXMUAnimRootMotion
 
 public:
 	UPROPERTY()
-	FString Name = "";
+	FXMUTransitionName Name;
 	TWeakObjectPtr<UAnimMontage> Montage = nullptr;
 	UPROPERTY()
 	bool bFinishedLastFrame = false;
 
 	virtual void Reset()
 	{
-		Name = "";
+		Name.Reset();
 		Montage = nullptr;
 		bFinishedLastFrame = false;
 	}
@@ -269,7 +305,7 @@ struct FXMURootMotionSource
 
 public:
 	UPROPERTY()
-	FString Name = "";
+	FXMUTransitionName Name;
 	TSharedPtr<FRootMotionSource_MoveToForce> RMS;
 	UPROPERTY()
 	int16 ID = 0;
@@ -278,7 +314,7 @@ public:
 
 	virtual void Reset()
 	{
-		Name = "";
+		Name.Reset();
 		RMS.Reset();
 		ID = 0;
 		bFinishedLastFrame = false;
@@ -294,6 +330,23 @@ enum class EXMUCapsuleScalingMode : uint8
 };
 
 
+UENUM(BlueprintType)
+enum class EXMUGroundInfoUpdateMode : uint8
+{
+	Synchronous,	// Trace down every frame GetGroundInfo is called while not walking
+	Asynchronous,	// Issue an async trace and serve the result of the previous one (see FXMUCharacterGroundInfo::bIsStale)
+	Batched,		// Like Asynchronous, but the trace runs in the UXMUGroundQuerySubsystem batch with every other character's
+	Predictive,		// Trace once, then follow the ballistic arc analytically until the prediction is invalidated
+};
+
+UENUM(BlueprintType)
+enum class EXMUSimulatedProxyLOD : uint8
+{
+	Full,		// Simulated every frame
+	Reduced,	// Simulated at SimulatedProxyReducedTickInterval
+	Far,		// Simulated at SimulatedProxyFarTickInterval, without floor checks and with lazy crouch capsule changes
+};
+
 /**
  * FXMUCharacterGroundInfo
  *
@@ -307,6 +360,9 @@ struct FXMUCharacterGroundInfo
 	FXMUCharacterGroundInfo()
 		: LastUpdateFrame(0)
 		, GroundDistance(0.0f)
+		, TimeToLand(-1.0f)
+		, bIsOutOfRange(false)
+		, bIsStale(false)
 	{}
 
 	uint64 LastUpdateFrame;
@@ -316,9 +372,50 @@ struct FXMUCharacterGroundInfo
 
 	UPROPERTY(BlueprintReadOnly)
 	float GroundDistance;
+
+	// Seconds until the character reaches GroundHitResult following its ballistic arc (0 when on the ground, -1 if it
+	// never will). Only computed in EXMUGroundInfoUpdateMode::Predictive.
+	UPROPERTY(BlueprintReadOnly)
+	float TimeToLand;
+
+	// True if no ground was found within the trace. GroundDistance is then the distance to the end of the trace, so the
+	// ground is at least that far.
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsOutOfRange;
+
+	// True if GroundHitResult comes from a trace issued in a previous frame (async mode). GroundDistance is still
+	// measured from the current location, but the ground itself may have changed since.
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsStale;
 };
 
 
+/**
+ * FXMUCharacterHeadroomInfo
+ *
+ *	Free vertical space above the character's capsule.  It only gets updated as needed, at most once per move.
+ */
+USTRUCT(BlueprintType)
+struct FXMUCharacterHeadroomInfo
+{
+	GENERATED_BODY()
+
+	FXMUCharacterHeadroomInfo()
+		: Clearance(0.0f)
+		, bIsBlocked(false)
+	{}
+
+	UPROPERTY(BlueprintReadOnly)
+	FHitResult CeilingHitResult;
+
+	// Distance the capsule can move up before hitting something (HeadroomTraceDistance if nothing was hit)
+	UPROPERTY(BlueprintReadOnly)
+	float Clearance;
+
+	// False if nothing was found within HeadroomTraceDistance, so there might be more room than Clearance
+	UPROPERTY(BlueprintReadOnly)
+	bool bIsBlocked;
+};
 
 USTRUCT(BlueprintType)
 struct FXMUResizeCapsuleHHResult
@@ -339,6 +436,197 @@ struct FXMUResizeCapsuleHHResult
 	bool Success;
 };
 
+/**
+ * FXMUReplayQueryCache
+ *
+ *	Results of the collision queries run while replaying saved moves after a correction. The world doesn't change
+ *	during a replay, so identical queries (same call site, type, shape and location) give identical results and only
+ *	run once per replay batch.
+ */
+struct FXMUReplayQueryCache
+{
+	enum class EQueryType : uint8
+	{
+		LineTrace,
+		Sweep,
+		OverlapBlocking,
+	};
+
+	struct FKey
+	{
+		FName TraceTag;
+		FVector Start;
+		FVector End;
+		FVector ShapeExtent;
+		ECollisionChannel Channel;
+		EQueryType Type;
+		uint8 ShapeType;
+
+		bool operator==(const FKey& Other) const
+		{
+			return TraceTag == Other.TraceTag && Type == Other.Type && Channel == Other.Channel && ShapeType == Other.ShapeType
+				&& Start == Other.Start && End == Other.End && ShapeExtent == Other.ShapeExtent;
+		}
+
+		friend uint32 GetTypeHash(const FKey& Key)
+		{
+			uint32 Hash = HashCombine(GetTypeHash(Key.TraceTag), GetTypeHash(Key.Start));
+			Hash = HashCombine(Hash, GetTypeHash(Key.End));
+			Hash = HashCombine(Hash, GetTypeHash(Key.ShapeExtent));
+			return HashCombine(Hash, (uint32(Key.Type) << 16) | (uint32(Key.ShapeType) << 8) | uint32(Key.Channel));
+		}
+	};
+
+	struct FResult
+	{
+		FHitResult Hit;
+		bool bBlocking = false;
+	};
+
+	TMap<FKey, FResult> Results;
+	bool bActive = false;
+	int32 NumHits = 0;
+	int32 NumMisses = 0;
+
+	void Begin()
+	{
+		Results.Reset();
+		NumHits = 0;
+		NumMisses = 0;
+		bActive = true;
+	}
+
+	void End()
+	{
+		Results.Reset();
+		bActive = false;
+	}
+};
+
+/**
+ * FXMUEncroachmentMemo
+ *
+ *	Remembers a failed IncreaseCapsuleHH so that the same attempt from the same spot doesn't run its overlap tests
+ *	again. Only the primitives that were blocking it are tracked: something new showing up can only keep the capsule
+ *	encroached, so the memo stays valid until the character moves or one of the blockers moves or goes away.
+ */
+struct FXMUEncroachmentMemo
+{
+	struct FBlocker
+	{
+		TWeakObjectPtr<const UPrimitiveComponent> Component;
+		FTransform Transform;
+	};
+
+	FVector Location = FVector::ZeroVector;
+	float TargetHalfHeight = 0.f;
+	EXMUCapsuleScalingMode ScalingMode = EXMUCapsuleScalingMode::CSM_Top;
+	TEnumAsByte<EMovementMode> MovementMode = MOVE_None;
+	float FloorDist = 0.f;
+	TArray<FBlocker, TInlineAllocator<4>> Blockers;
+	bool bValid = false;
+
+	void Reset()
+	{
+		Blockers.Reset();
+		bValid = false;
+	}
+};
+
+/**
+ * FXMUAccelerationPredictor
+ *
+ *	Acceleration of a simulated proxy between two ReplicatedAcceleration updates. A new sample is blended in from the
+ *	acceleration that was displayed when it arrived, and its XY direction keeps turning at the rate it turned between
+ *	the last two samples, so proxies don't stop turning while waiting for the next update. The blend start turns with
+ *	it, otherwise a blend time longer than the update interval leaves the displayed direction further and further behind.
+ */
+struct FXMUAccelerationPredictor
+{
+	FVector LastSample = FVector::ZeroVector;
+	double LastSampleTime = 0.0;
+	// Acceleration displayed when LastSample arrived, blended out over the blend time
+	FVector BlendStart = FVector::ZeroVector;
+	// Turn rate of the XY direction between the last two samples (radians per second)
+	float AngularRate = 0.f;
+	bool bHasSample = false;
+
+	void Reset()
+	{
+		*this = FXMUAccelerationPredictor();
+	}
+
+	void AddSample(const FVector& Sample, double Time, const FVector& DisplayedAcceleration)
+	{
+		AngularRate = 0.f;
+		const double DeltaTime = Time - LastSampleTime;
+		// Directions of very small accelerations are mostly quantization noise
+		if (bHasSample && DeltaTime > UE_KINDA_SMALL_NUMBER && LastSample.SizeSquared2D() > 1.0 && Sample.SizeSquared2D() > 1.0)
+		{
+			const double DeltaRadians = FMath::FindDeltaAngleRadians(FMath::Atan2(LastSample.Y, LastSample.X), FMath::Atan2(Sample.Y, Sample.X));
+			AngularRate = static_cast<float>(DeltaRadians / DeltaTime);
+		}
+
+		BlendStart = bHasSample ? DisplayedAcceleration : Sample;
+		LastSample = Sample;
+		LastSampleTime = Time;
+		bHasSample = true;
+	}
+
+	FVector Predict(double Time, float BlendTime, float MaxExtrapolationTime, float MaxAngularRate) const
+	{
+		if (!bHasSample)
+		{
+			return FVector::ZeroVector;
+		}
+
+		const float Elapsed = FMath::Max(static_cast<float>(Time - LastSampleTime), 0.f);
+		const float Radians = FMath::Clamp(AngularRate, -MaxAngularRate, MaxAngularRate) * FMath::Min(Elapsed, MaxExtrapolationTime);
+		const FQuat Turn(FVector::UpVector, Radians);
+		const FVector Extrapolated = Turn.RotateVector(LastSample);
+		if (Elapsed >= BlendTime)
+		{
+			return Extrapolated;
+		}
+		return FMath::Lerp(Turn.RotateVector(BlendStart), Extrapolated, Elapsed / BlendTime);
+	}
+};
+
+
+/**
+ * FXMUResourceCorrection
+ *
+ *	Server resource state at the time of a client move. Sent instead of a full correction when only the resources
+ *	are out of sync.
+ */
+USTRUCT()
+struct FXMUResourceCorrection
+{
+	GENERATED_BODY()
+
+	FXMUResourceCorrection()
+		: TimeStamp(0.f)
+		, Stamina(0.f)
+		, bStaminaDrained(false)
+		, Charge(0.f)
+		, bChargeDrained(false)
+		, CoyoteTimeDuration(0.f)
+	{}
+
+	UPROPERTY()
+	float TimeStamp;
+	UPROPERTY()
+	float Stamina;
+	UPROPERTY()
+	bool bStaminaDrained;
+	UPROPERTY()
+	float Charge;
+	UPROPERTY()
+	bool bChargeDrained;
+	UPROPERTY()
+	float CoyoteTimeDuration;
+};
+
 
 /**
  * 
@@ -364,12 +652,14 @@ public:
 	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
 	virtual void UpdateCharacterStateAfterMovement(float DeltaSeconds) override;
 	virtual void SimulateMovement(float DeltaTime) override;
+	virtual void FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, bool bCanUseCachedResult, const FHitResult* DownwardSweepResult = nullptr) const override;
 	virtual bool CanAttemptJump() const override;
 	virtual bool DoJump(bool bReplayingMoves) override;
 	virtual void Crouch(bool bClientSimulation) override;
 	virtual void UnCrouch(bool bClientSimulation) override;
 	virtual void CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration) override;
 protected:
+	virtual void SimulatedTick(float DeltaSeconds) override;
 	virtual void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
 	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
 
@@ -423,8 +713,124 @@ protected:
 public:
 	void SetReplicatedAcceleration(const FVector& InAcceleration);
 protected:
+	/** Acceleration simulated proxies display at Time (see FXMUAccelerationPredictor) */
+	FVector PredictReplicatedAcceleration(double Time) const;
+	
 	UPROPERTY(Transient)
 	bool bHasReplicatedAcceleration = false;
+	FXMUAccelerationPredictor ReplicatedAccelerationPredictor;
+
+	// Lets simulated proxies blend between ReplicatedAcceleration updates and keep turning at the last observed rate,
+	// instead of holding the last received value
+	UPROPERTY(Category="Character Movement (Networking)", EditAnywhere, BlueprintReadWrite)
+	bool bPredictReplicatedAcceleration = false;
+	// Time a new ReplicatedAcceleration sample takes to fully replace the displayed acceleration
+	UPROPERTY(Category="Character Movement (Networking)", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s", EditCondition="bPredictReplicatedAcceleration"))
+	float ReplicatedAccelerationBlendTime = 0.1f;
+	// The direction stops turning this long after the last sample
+	UPROPERTY(Category="Character Movement (Networking)", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s", EditCondition="bPredictReplicatedAcceleration"))
+	float ReplicatedAccelerationMaxExtrapolationTime = 0.25f;
+	UPROPERTY(Category="Character Movement (Networking)", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="deg/s", EditCondition="bPredictReplicatedAcceleration"))
+	float ReplicatedAccelerationMaxTurnRate = 720.f;
+	// Changes of ReplicatedAcceleration closer than this to the last sent one are held back (the latest value goes out
+	// once the interval is over). 0 sends every change
+	UPROPERTY(Category="Character Movement (Networking)", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s"))
+	float ReplicatedAccelerationMinSendInterval = 0.f;
+
+public:
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	bool IsIdleSleeping() const { return bIdleSleeping; }
+	/** Leaves idle sleep, so the next tick runs the full movement update */
+	void WakeFromIdleSleep();
+protected:
+	/** Returns true if nothing would change by running the movement update this tick: no input, no velocity, no
+	 * pending forces, standing on a static floor, resources not regenerating and no crouch transition.
+	 * Only for server characters that are not driven by a remote client (those move through ServerMove RPCs). */
+	virtual bool CanIdleSleep() const;
+	virtual void EnterIdleSleep();
+	
+	// Lets server characters that stand still skip the movement update entirely until something wakes them
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite)
+	bool bEnableIdleSleep = false;
+	// Time CanIdleSleep has to be true before going to sleep
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s", EditCondition="bEnableIdleSleep"))
+	float IdleSleepDelay = 0.5f;
+private:
+	bool bIdleSleeping = false;
+	float IdleTime = 0.f;
+	// State we went to sleep with, anything changing it from outside the movement component wakes us
+	FVector IdleSleepLocation = FVector::ZeroVector;
+	FRotator IdleSleepControlRotation = FRotator::ZeroRotator;
+
+public:
+	EXMUSimulatedProxyLOD GetSimulatedProxyLOD() const { return SimulatedProxyLOD; }
+protected:
+	/** Picks the LOD of this simulated proxy from its distance to the local camera, whether it was rendered recently
+	 * and how much of the screen it covers */
+	virtual EXMUSimulatedProxyLOD ComputeSimulatedProxyLOD() const;
+	virtual void SetSimulatedProxyLOD(EXMUSimulatedProxyLOD NewLOD);
+	float GetSimulatedProxyTickInterval() const;
+	/** Camera of the local player, simulated proxies pick their LOD and collision from their distance to it */
+	const APlayerCameraManager* GetLocalCameraManager() const;
+
+	// Lets simulated proxies far from the local camera, off screen or small on screen run their movement less often
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite)
+	bool bEnableSimulatedProxyLOD = false;
+	// Simulated proxies further than this from the local camera use EXMUSimulatedProxyLOD::Reduced
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="cm", EditCondition="bEnableSimulatedProxyLOD"))
+	float SimulatedProxyLODNearDistance = 2500.f;
+	// Simulated proxies further than this from the local camera use EXMUSimulatedProxyLOD::Far
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="cm", EditCondition="bEnableSimulatedProxyLOD"))
+	float SimulatedProxyLODFarDistance = 6000.f;
+	// Simulated proxies whose capsule covers less than this fraction of the screen height use EXMUSimulatedProxyLOD::Far
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", EditCondition="bEnableSimulatedProxyLOD"))
+	float SimulatedProxyLODMinScreenSize = 0.02f;
+	// Simulated proxies not rendered for this long use EXMUSimulatedProxyLOD::Far
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s", EditCondition="bEnableSimulatedProxyLOD"))
+	float SimulatedProxyLODRenderTolerance = 0.2f;
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s", EditCondition="bEnableSimulatedProxyLOD"))
+	float SimulatedProxyReducedTickInterval = 1.f / 30.f;
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s", EditCondition="bEnableSimulatedProxyLOD"))
+	float SimulatedProxyFarTickInterval = 0.1f;
+private:
+	EXMUSimulatedProxyLOD SimulatedProxyLOD = EXMUSimulatedProxyLOD::Full;
+	// Frame time not simulated yet, run in one step once it reaches the tick interval of the current LOD
+	float SimulatedProxyPendingTime = 0.f;
+	// Set while SimulateMovement runs for a far or collision-free proxy, makes FindFloor keep the current floor
+	bool bSkipProxyFloorCheck = false;
+
+public:
+	/** True while this simulated proxy is kept out of the physics scene because of its distance to the local camera */
+	bool IsProxyCollisionDisabled() const { return bProxyCollisionDisabled; }
+	/** True while crouch changes of this simulated proxy only move its mesh, without resizing the capsule */
+	bool IsProxyCapsuleFrozen() const { return bProxyCapsuleFrozen; }
+protected:
+	/** Takes this simulated proxy out of the physics scene (or back in) depending on its distance to the local camera */
+	void UpdateDistantProxyCollision();
+	/** Freezes the capsule size of far or collision-free simulated proxies, and resizes it to the current crouch state
+	 * when they thaw */
+	void UpdateProxyCapsuleFreeze();
+	
+	// Lets simulated proxies far from the local camera leave the physics scene. Their crouch state only moves the mesh
+	// until they come back
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite)
+	bool bDisableDistantProxyCollision = false;
+	// Simulated proxies further than this from the local camera disable their collision
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="cm", EditCondition="bDisableDistantProxyCollision"))
+	float DistantProxyCollisionDistance = 8000.f;
+	// How much closer than DistantProxyCollisionDistance a collision-free proxy has to come to get its collision back
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="cm", EditCondition="bDisableDistantProxyCollision"))
+	float DistantProxyCollisionHysteresis = 500.f;
+private:
+	bool bProxyCollisionDisabled = false;
+	// Collision the capsule had before UpdateDistantProxyCollision disabled it
+	TEnumAsByte<ECollisionEnabled::Type> ProxyCollisionEnabled = ECollisionEnabled::QueryAndPhysics;
+	bool bProxyCapsuleFrozen = false;
+	// Set when a crouch change happened while frozen, the capsule has to be resized when thawing
+	bool bFrozenProxyCapsuleDirty = false;
+	// Unscaled half height the capsule of this simulated proxy should have for its crouch state (< 0 before the first
+	// resize, meaning the default one)
+	float ProxyLogicalHalfHeight = -1.f;
 
 public:
 	// Returns the current ground info.  Calling this will update the ground info if it's out of date.
@@ -434,6 +840,89 @@ protected:
 	// Cached ground info for the character.  Do not access this directly! It's only updated when accessed via GetGroundInfo().
 	FXMUCharacterGroundInfo CachedGroundInfo;
 
+	// What CachedGroundInfo was computed from
+	struct FGroundInfoCacheKey
+	{
+		FVector Location = FVector::ZeroVector;
+		float CapsuleHalfHeight = 0.f;
+		double SimulationTime = 0.0;
+		TEnumAsByte<EMovementMode> MovementMode = MOVE_None;
+		uint8 CustomMovementMode = 0;
+	};
+	FGroundInfoCacheKey GroundInfoCacheKey;
+	bool bGroundInfoCacheValid = false;
+
+public:
+	// Returns the free space above the capsule.  Calling this will sweep up if the character moved or resized since
+	// the last call, and can be shared by anything needing the clearance above the character (uncrouch, vault, mantle...).
+	UFUNCTION(BlueprintCallable, Category = "XyloMovementUtil|CharacterMovement")
+	const FXMUCharacterHeadroomInfo& GetHeadroomInfo();
+protected:
+	// How far up GetHeadroomInfo looks for a ceiling
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="cm"))
+	float HeadroomTraceDistance = 200.f;
+	
+	// Cached headroom info.  Do not access this directly! It's only updated when accessed via GetHeadroomInfo().
+	FXMUCharacterHeadroomInfo CachedHeadroomInfo;
+	FVector HeadroomCacheLocation = FVector::ZeroVector;
+	float HeadroomCacheHalfHeight = 0.f;
+	double HeadroomCacheSimulationTime = 0.0;
+	bool bHeadroomCacheValid = false;
+
+	// Time of the movement simulation: the time stamp of the move being performed (or advanced by each move where
+	// there is none). It goes back in time when replaying moves after a correction, and forward to the next live move
+	// once done, so caches keyed on it must only compare it for equality or by absolute difference (or, like the
+	// ground prediction, treat a negative age as invalid)
+	double MovementSimulationTime = 0.0;
+	// Time stamp of the move MoveAutonomous is performing, see UpdateCharacterStateBeforeMovement
+	double AutonomousMoveTimeStamp = 0.0;
+	bool bHasAutonomousMoveTimeStamp = false;
+
+	// How GetGroundInfo traces for the ground while not walking. Asynchronous and Batched avoid blocking the game
+	// thread on long traces, at the cost of serving the ground found by the previous frame's trace.
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite)
+	EXMUGroundInfoUpdateMode GroundInfoUpdateMode = EXMUGroundInfoUpdateMode::Synchronous;
+
+	// Predictive mode: max time a prediction is used before tracing again
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s", EditCondition="GroundInfoUpdateMode==EXMUGroundInfoUpdateMode::Predictive"))
+	float GroundPredictionMaxAge = 0.5f;
+	// Predictive mode: trace again when the velocity differs this much from the predicted one (e.g. jump, launch, hit a wall)
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="cm/s", EditCondition="GroundInfoUpdateMode==EXMUGroundInfoUpdateMode::Predictive"))
+	float GroundPredictionVelocityTolerance = 50.f;
+	// Predictive mode: trace again when the character moved this far horizontally from the traced point, since the
+	// ground under it may have changed
+	UPROPERTY(Category="Foundation Movement", EditAnywhere, BlueprintReadWrite, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="cm", EditCondition="GroundInfoUpdateMode==EXMUGroundInfoUpdateMode::Predictive"))
+	float GroundPredictionDriftTolerance = 50.f;
+
+	void UpdateGroundInfoSync(float CapsuleHalfHeight, const FVector& TraceStart);
+	void UpdateGroundInfoPredictive(float CapsuleHalfHeight, const FVector& Location);
+	/** Serves the last deferred trace result and requests the next one (Asynchronous and Batched modes) */
+	void UpdateGroundInfoDeferred(float CapsuleHalfHeight, const FVector& TraceStart);
+	/** Asynchronous and Batched modes while replaying moves after a correction */
+	void UpdateGroundInfoReplayed(float CapsuleHalfHeight, const FVector& TraceStart);
+	void OnGroundTraceCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+	void SetGroundInfoFromHit(const FHitResult& HitResult, float CapsuleHalfHeight, const FVector& Location);
+	/** End of a ground trace long enough to cover the next XMU.GroundTraceLookahead seconds of fall */
+	FVector GetGroundTraceEnd(float CapsuleHalfHeight, const FVector& TraceStart) const;
+public:
+	/** Called with the result of a ground trace requested in Asynchronous or Batched mode */
+	void ReceiveDeferredGroundHit(const FHitResult& HitResult);
+	
+private:
+	FTraceHandle GroundTraceHandle;
+	FTraceDelegate GroundTraceDelegate;
+	// Set while a request is queued in UXMUGroundQuerySubsystem
+	bool bGroundQueryQueued = false;
+	// Ground prediction state (Predictive mode)
+	FVector GroundPredictionLocation = FVector::ZeroVector;
+	FVector GroundPredictionVelocity = FVector::ZeroVector;
+	double GroundPredictionTime = 0.0;
+	bool bHasGroundPrediction = false;
+	// Result of the last completed deferred ground trace
+	FHitResult DeferredGroundHitResult;
+	uint64 DeferredGroundHitFrame = 0;
+	bool bHasDeferredGroundHit = false;
+
 public:
 	virtual bool CheckOverrideJumpInput(float DeltaSeconds);
 
@@ -442,6 +931,21 @@ public:
 protected:
 	virtual void IncreaseCapsuleHH(float ClampedNewHalfHeight, float ScaledHalfHeightAdjust, EXMUCapsuleScalingMode ScalingMode, bool bClientSimulation, FXMUResizeCapsuleHHResult& Result);
 	virtual void DecreaseCapsuleHH(float ClampedNewHalfHeight, float ScaledHalfHeightAdjust, EXMUCapsuleScalingMode ScalingMode, bool bClientSimulation, FXMUResizeCapsuleHHResult& Result);	
+	/** ResizeCapsuleHH for simulated proxies with a frozen capsule: only tracks the half height and moves the mesh */
+	void ResizeFrozenProxyCapsuleHH(float NewCapsuleHalfHeight, FXMUResizeCapsuleHHResult& Result);
+
+	/** Collision queries used by the movement code. Same as the UWorld ones, but results are reused while replaying
+	 * moves (see FXMUReplayQueryCache) */
+	bool LineTraceSingleByChannelCached(FHitResult& OutHit, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel, const FCollisionQueryParams& Params, const FCollisionResponseParams& ResponseParam = FCollisionResponseParams::DefaultResponseParam);
+	bool SweepSingleByChannelCached(FHitResult& OutHit, const FVector& Start, const FVector& End, ECollisionChannel TraceChannel, const FCollisionShape& CollisionShape, const FCollisionQueryParams& Params, const FCollisionResponseParams& ResponseParam = FCollisionResponseParams::DefaultResponseParam);
+	bool OverlapBlockingTestByChannelCached(const FVector& Pos, ECollisionChannel TraceChannel, const FCollisionShape& CollisionShape, const FCollisionQueryParams& Params, const FCollisionResponseParams& ResponseParam = FCollisionResponseParams::DefaultResponseParam);
+	FXMUReplayQueryCache ReplayQueryCache;
+
+	/** True if the same IncreaseCapsuleHH already failed here and nothing that blocked it has changed since */
+	bool MatchesEncroachmentMemo(float ClampedNewHalfHeight, EXMUCapsuleScalingMode ScalingMode) const;
+	/** Records a failed IncreaseCapsuleHH along with the primitives blocking the area it tested */
+	void RecordEncroachmentMemo(float ClampedNewHalfHeight, float ScaledHalfHeightAdjust, EXMUCapsuleScalingMode ScalingMode, const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParams);
+	FXMUEncroachmentMemo EncroachmentMemo;
 	
 /*--------------------------------------------------------------------------------------------------------------------*/
 
@@ -452,7 +956,7 @@ public:
 	FXMUAnimRootMotion AnimRootMotionTransition;
 protected:
 	/** Override to run logic after playing a root motion source transition */
-	virtual void PostAnimRootMotionTransition(FString TransitionName);
+	virtual void PostAnimRootMotionTransition(FXMUTransitionName TransitionName);
 protected:
 	bool bHadAnimRootMotion = false;
 
@@ -465,7 +969,7 @@ public:
 	FXMURootMotionSource RootMotionSourceTransition;
 protected:
 	/** Override to run logic after playing a root motion source transition */
-	virtual void PostRootMotionSourceTransition(FString TransitionName);
+	virtual void PostRootMotionSourceTransition(FXMUTransitionName TransitionName);
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 	
@@ -520,6 +1024,9 @@ public:
 	void SetMaxCoyoteTimeDuration(float NewMaxCoyoteTimeDuration);
 	void SetCoyoteTimeFullDurationVelocity(float NewCoyoteTimeVelocityScale);
 	void DebugCoyoteTimeDuration() const;
+	/** Range and bits used to send CoyoteTimeDuration over the network. Taken from the class defaults so client and server always
+	 * agree: values above the default MaxCoyoteTimeDuration (after raising it at runtime) are sent as raw floats */
+	FXMUNetQuantizedRange GetNetworkCoyoteTimeDurationQuantization() const;
 protected:
 	virtual void OnCoyoteTimeDurationChanged(float PrevValue, float NewValue);
 
@@ -537,6 +1044,20 @@ private:
 	/** Maximum CoyoteTimeDuration difference that is allowed between client and server before a correction occurs. */
 	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0.0", UIMin="0.0"))
 	float NetworkCoyoteTimeDurationCorrectionThreshold;
+	/** Bits used to send CoyoteTimeDuration over the network (0 sends the raw float). Raised automatically if needed
+	 * to keep the quantization error below NetworkCoyoteTimeDurationCorrectionThreshold. */
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0", ClampMax="24", UIMin="0", UIMax="24"))
+	uint8 NetworkCoyoteTimeDurationQuantizationBits;
+	
+/*--------------------------------------------------------------------------------------------------------------------*/
+	
+/*--------------------------------------------------------------------------------------------------------------------*/
+	/* Resources */
+
+protected:
+	// Sum of the DeltaSeconds of every move, used to evaluate resource regeneration lazily. Only goes forward (replays
+	// restore resources through SetStamina / SetCharge, which re-anchor them)
+	double ResourceRegenClock = 0.0;
 	
 /*--------------------------------------------------------------------------------------------------------------------*/
 	
@@ -544,8 +1065,9 @@ private:
 	/* Stamina */
 	
 public:
+	/** Current Stamina, including the regeneration since it was last set */
 	UFUNCTION(BlueprintCallable)
-	float GetStamina() const { return Stamina; }
+	float GetStamina() const { return FMath::Clamp(Stamina + StaminaRegenRate * static_cast<float>(ResourceRegenClock - StaminaAnchorTime), 0.f, MaxStamina); }
 	UFUNCTION(BlueprintCallable)
 	float GetMaxStamina() const { return MaxStamina; }
 	bool IsStaminaDrained() const { return bStaminaDrained; }
@@ -553,21 +1075,38 @@ public:
 	void SetMaxStamina(float NewMaxStamina);
 	void SetStaminaDrained(bool bNewValue);
 	void DebugStamina() const;
+	/** Range and bits used to send Stamina over the network. Taken from the class defaults so client and server always
+	 * agree: values above the default MaxStamina (after raising it at runtime) are sent as raw floats */
+	FXMUNetQuantizedRange GetNetworkStaminaQuantization() const;
 protected:
     /*
      * Drain state entry and exit is handled here. Drain state is used to prevent rapid re-entry of sprinting or other
      * such abilities before sufficient stamina has regenerated. However, in the default implementation, 100%
-     * stamina must be regenerated. Consider overriding this, check the implementation's comment for more information.
+     * stamina must be regenerated. Consider overriding GetStaminaDrainedAfterChange, check the implementation's comment
+     * for more information.
      */
     virtual void OnStaminaChanged(float PrevValue, float NewValue);
+    /** Drain state once Stamina got to NewValue, given the previous one. Used by OnStaminaChanged and to re-apply the
+     * moves made after a resource correction, so it must not have side effects */
+    virtual bool GetStaminaDrainedAfterChange(float NewValue, bool bWasDrained) const;
+    /** Value at which regeneration must be materialized so OnStaminaChanged gets called (see UpdateStaminaBeforeMovement).
+     * Override this if OnStaminaChanged reacts to other values. */
+    virtual float GetStaminaRegenEventValue() const { return StaminaRegenRate > 0.f ? MaxStamina : 0.f; }
+    /** Applies the regeneration since the last change to Stamina and calls OnStaminaChanged */
+    void MaterializeStamina();
+    void UpdateStaminaRegenEventTime();
 
     virtual void OnMaxStaminaChanged(float PrevValue, float NewValue) {}
     virtual void OnStaminaDrained() {}
     virtual void OnStaminaDrainRecovered() {}
 protected:
-	/** THIS SHOULD ONLY BE MODIFIED IN DERIVED CLASSES FROM OnStaminaChanged AND NOWHERE ELSE */
+	/** THIS SHOULD ONLY BE MODIFIED IN DERIVED CLASSES FROM OnStaminaChanged AND NOWHERE ELSE
+	 * Value at StaminaAnchorTime, regeneration is applied lazily by GetStamina */
 	UPROPERTY()
 	float Stamina;
+	double StaminaAnchorTime = 0.0;
+	// ResourceRegenClock at which regeneration reaches GetStaminaRegenEventValue
+	double StaminaRegenEventTime = 0.0;
 private:
 	UPROPERTY(EditDefaultsOnly, Category = "Stamina")
 	float StaminaRegenRate;
@@ -578,6 +1117,10 @@ private:
 	/** Maximum stamina difference that is allowed between client and server before a correction occurs. */
 	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0.0", UIMin="0.0"))
 	float NetworkStaminaCorrectionThreshold;
+	/** Bits used to send Stamina over the network (0 sends the raw float). Raised automatically if needed to keep the
+	 * quantization error below NetworkStaminaCorrectionThreshold. */
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0", ClampMax="24", UIMin="0", UIMax="24"))
+	uint8 NetworkStaminaQuantizationBits;
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 
@@ -585,8 +1128,9 @@ private:
 	/* Charge */
 	
 public:
+	/** Current Charge, including the regeneration since it was last set */
 	UFUNCTION(BlueprintCallable)
-	float GetCharge() const { return Charge; }
+	float GetCharge() const { return FMath::Clamp(Charge + ChargeRegenRate * static_cast<float>(ResourceRegenClock - ChargeAnchorTime), 0.f, MaxCharge); }
 	UFUNCTION(BlueprintCallable)
 	float GetMaxCharge() const { return MaxCharge; }
 	bool IsChargeDrained() const { return bChargeDrained; }
@@ -594,21 +1138,38 @@ public:
 	void SetMaxCharge(float NewMaxCharge);
 	void SetChargeDrained(bool bNewValue);
 	void DebugCharge() const;
+	/** Range and bits used to send Charge over the network. Taken from the class defaults so client and server always
+	 * agree: values above the default MaxCharge (after raising it at runtime) are sent as raw floats */
+	FXMUNetQuantizedRange GetNetworkChargeQuantization() const;
 protected:
 	/*
 	 * Drain state entry and exit is handled here. Drain state is used to prevent rapid re-entry of sprinting or other
 	 * such abilities before sufficient Charge has regenerated. However, in the default implementation, 100%
-	 * Charge must be regenerated. Consider overriding this, check the implementation's comment for more information.
+	 * Charge must be regenerated. Consider overriding GetChargeDrainedAfterChange, check the implementation's comment
+	 * for more information.
 	 */
 	virtual void OnChargeChanged(float PrevValue, float NewValue);
+	/** Drain state once Charge got to NewValue, given the previous one. Used by OnChargeChanged and to re-apply the
+	 * moves made after a resource correction, so it must not have side effects */
+	virtual bool GetChargeDrainedAfterChange(float NewValue, bool bWasDrained) const;
+	/** Value at which regeneration must be materialized so OnChargeChanged gets called (see UpdateChargeBeforeMovement).
+	 * Override this if OnChargeChanged reacts to other values. */
+	virtual float GetChargeRegenEventValue() const { return ChargeRegenRate > 0.f ? MaxCharge : 0.f; }
+	/** Applies the regeneration since the last change to Charge and calls OnChargeChanged */
+	void MaterializeCharge();
+	void UpdateChargeRegenEventTime();
 
 	virtual void OnMaxChargeChanged(float PrevValue, float NewValue) {}
 	virtual void OnChargeDrained() {}
 	virtual void OnChargeDrainRecovered() {}
 protected:
-	/** THIS SHOULD ONLY BE MODIFIED IN DERIVED CLASSES FROM OnChargeChanged AND NOWHERE ELSE */
+	/** THIS SHOULD ONLY BE MODIFIED IN DERIVED CLASSES FROM OnChargeChanged AND NOWHERE ELSE
+	 * Value at ChargeAnchorTime, regeneration is applied lazily by GetCharge */
 	UPROPERTY()
 	float Charge;
+	double ChargeAnchorTime = 0.0;
+	// ResourceRegenClock at which regeneration reaches GetChargeRegenEventValue
+	double ChargeRegenEventTime = 0.0;
 private:
 	UPROPERTY(EditDefaultsOnly, Category = "Charge")
 	float ChargeRegenRate;
@@ -619,6 +1180,10 @@ private:
 	/** Maximum stamina difference that is allowed between client and server before a correction occurs. */
 	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0.0", UIMin="0.0"))
 	float NetworkChargeCorrectionThreshold;
+	/** Bits used to send Charge over the network (0 sends the raw float). Raised automatically if needed to keep the
+	 * quantization error below NetworkChargeCorrectionThreshold. */
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0", ClampMax="24", UIMin="0", UIMax="24"))
+	uint8 NetworkChargeQuantizationBits;
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 	
@@ -641,6 +1206,61 @@ protected:
 	/** If bUpdatePosition is true, then replay any unacked moves. Returns whether any moves were actually replayed.
 	 * <p> Call Context: called by TickComponent */ 
 	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+	/** Sends the packed moves to the server. Overridden to count ServerMove RPCs.
+	 * <p> Call Context: called by CallServerMove */
+	virtual void CallServerMovePacked(const FSavedMove_Character* NewMove, const FSavedMove_Character* PendingMove, const FSavedMove_Character* OldMove) override;
+
+protected:
+	/** Returns true if the resources the client sent are too far from the server ones */
+	virtual bool ServerCheckClientResourceError(const FXMUFoundationNetworkMoveData& MoveData) const;
+	/** Send the current resources to the owning client, throttled by NetworkMinTimeBetweenResourceCorrections.
+	 * Returns false if the correction was held back by the throttle */
+	virtual bool ServerSendResourceCorrection(float ClientTimeStamp);
+	/** Overwrite the resources with the server ones and re-apply the resource deltas of the moves made after the
+	 * corrected one, without moving the capsule or replaying movement. The drain state of those moves is recomputed
+	 * along the way */
+	UFUNCTION(Client, Unreliable)
+	void ClientAdjustResources(const FXMUResourceCorrection& Correction);
+	virtual void ClientAdjustResources_Implementation(const FXMUResourceCorrection& Correction);
+protected:
+	/** If true, a client whose position is correct but whose resources are out of sync gets a ClientAdjustResources
+	 * instead of a full position correction (which would replay all unacked moves) */
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly)
+	bool bUseResourceOnlyCorrections;
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s", EditCondition="bUseResourceOnlyCorrections"))
+	float NetworkMinTimeBetweenResourceCorrections;
+private:
+	float ServerLastResourceCorrectionTime = -UE_BIG_NUMBER;
+
+public:
+	bool UsesNetworkResourceChecksum() const { return bUseNetworkResourceChecksum; }
+	/** Checksum of the given resource values, quantized to half their correction thresholds */
+	uint32 GetNetworkResourceChecksum(float InStamina, float InCharge, float InCoyoteTimeDuration) const;
+	/** Returns true if the client checksum matches the current resource state or one of its neighbouring quantization
+	 * steps, so errors below half the correction threshold never trigger a correction. A wrong state is still accepted
+	 * when its checksum collides with one of those 27 steps: about 27 / 2^NetworkResourceChecksumBits per mismatching
+	 * move (27 / 4096, ~0.7%, with the default 12 bits). Resources that keep changing get a new chance to be caught
+	 * every move, a desynced state that doesn't change keeps colliding until it does */
+	bool MatchesNetworkResourceChecksum(uint32 ClientChecksum) const;
+	uint8 GetNetworkResourceChecksumBits() const { return FMath::Clamp<uint8>(NetworkResourceChecksumBits, 1, 31); }
+	uint8 GetNetworkResourceDeltaBits() const { return NetworkResourceDeltaBits; }
+private:
+	uint32 GetNetworkResourceChecksum(const FIntVector& Steps) const;
+	FIntVector GetNetworkResourceChecksumSteps(float InStamina, float InCharge, float InCoyoteTimeDuration) const;
+protected:
+	/** If true, clients send a checksum of their predicted Stamina, Charge and CoyoteTimeDuration instead of the values.
+	 * The server compares it with its own state, and the full values are only sent (back) in a correction when the
+	 * checksum disagrees. */
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly)
+	bool bUseNetworkResourceChecksum;
+	/** Bits used by the resource checksum. A wrong state passes the check about 27 / 2^Bits of the time (see
+	 * MatchesNetworkResourceChecksum), each bit removed doubles that */
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="4", ClampMax="31", UIMin="4", UIMax="31", EditCondition="bUseNetworkResourceChecksum"))
+	uint8 NetworkResourceChecksumBits;
+	/** Bits (sign included) used to send the resources of Pending and Old moves as a difference in quantization steps
+	 * from the New move. Differences that don't fit are sent as absolute values. 0 disables delta encoding */
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0", ClampMax="16", UIMin="0", UIMax="16"))
+	uint8 NetworkResourceDeltaBits;
 	
 protected:
 	virtual void UpdateFromFoundationCompressedFlags();
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "XMUGroundQuerySubsystem.generated.h"
+
+class UXMUFoundationMovement;
+
+/**
+ * FXMUGroundQueryRequest
+ *
+ *	A ground trace queued by UXMUFoundationMovement::GetGroundInfo in EXMUGroundInfoUpdateMode::Batched.
+ */
+struct FXMUGroundQueryRequest
+{
+	TWeakObjectPtr<UXMUFoundationMovement> MovementComponent;
+	FVector Start;
+	FVector End;
+	ECollisionChannel CollisionChannel;
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+};
+
+/**
+ * UXMUGroundQuerySubsystem
+ *
+ *	Collects the ground traces requested by every movement component of the world during the frame and runs them
+ *	back to back in a single batch (sorted by area so consecutive queries touch the same part of the physics scene).
+ *	Results are handed back to the movement components, which serve them from the next GetGroundInfo call.
+ */
+UCLASS()
+class XYLOMOVEMENTUTIL_API UXMUGroundQuerySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Queues a ground trace for this frame's batch. A component can only have one request per batch */
+	void RequestGroundTrace(FXMUGroundQueryRequest&& Request);
+	int32 GetNumPendingRequests() const { return PendingRequests.Num(); }
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Runs all pending requests and sends the results back to their movement components */
+	void FlushRequests();
+
+private:
+	TArray<FXMUGroundQueryRequest> PendingRequests;
+};
@@ -0,0 +1,225 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * FXMUNetQuantizedRange
+ *
+ *	Describes how a float in [0, MaxValue] is sent over the network: the range is mapped onto NumBits using
+ *	round-to-nearest, so the error is at most half a step. Values outside the range (ie: above a max raised at
+ *	runtime) are sent as raw floats behind an escape bit. NumBits == 0 means the raw float is always sent.
+ */
+struct FXMUNetQuantizedRange
+{
+	static constexpr uint8 MaxNumBits = 24; // float mantissa, more bits would not add precision
+
+	FXMUNetQuantizedRange()
+		: MaxValue(0.f)
+		, NumBits(0)
+	{}
+
+	FXMUNetQuantizedRange(float InMaxValue, uint8 InNumBits)
+		: MaxValue(InMaxValue)
+		, NumBits(FMath::Min(InNumBits, MaxNumBits))
+	{}
+
+	float MaxValue;
+	uint8 NumBits;
+
+	bool IsQuantized() const { return NumBits > 0 && MaxValue > 0.f; }
+	bool IsInRange(float Value) const { return Value >= 0.f && Value <= MaxValue; }
+	uint32 GetMaxQuantized() const { return (1u << NumBits) - 1; }
+	/** Largest error introduced by Quantize / Dequantize */
+	float GetMaxError() const { return IsQuantized() ? 0.5f * MaxValue / GetMaxQuantized() : 0.f; }
+
+	/** Values outside [0, MaxValue] are clamped to the range (SerializeOptional sends them raw instead) */
+	uint32 Quantize(float Value) const
+	{
+		if (!IsQuantized())
+		{
+			return 0;
+		}
+		const float ClampedValue = FMath::Clamp(Value, 0.f, MaxValue);
+		return static_cast<uint32>(FMath::Min<int64>(FMath::RoundToInt64(double(ClampedValue) / MaxValue * GetMaxQuantized()), GetMaxQuantized()));
+	}
+
+	float Dequantize(uint32 Quantized) const
+	{
+		if (!IsQuantized())
+		{
+			return 0.f;
+		}
+		return static_cast<float>(double(FMath::Min(Quantized, GetMaxQuantized())) * MaxValue / GetMaxQuantized());
+	}
+
+	/** Returns the value the other side of the connection will read */
+	float Snap(float Value) const
+	{
+		return IsQuantized() && IsInRange(Value) ? Dequantize(Quantize(Value)) : Value;
+	}
+
+	/** Same layout as FCharacterNetworkMoveData::SerializeOptionalValue: one bit telling if the value is non zero,
+	 * followed by NumBits (or a raw float if not quantized). When quantized, an escape bit tells if the value is in
+	 * range, if not the raw float is sent so the other side reads exactly the same value */
+	void SerializeOptional(FArchive& Ar, float& Value) const
+	{
+		uint32 Quantized = Ar.IsSaving() ? Quantize(Value) : 0;
+		uint8 bInRange = Ar.IsSaving() ? IsInRange(Value) : 0;
+		uint8 bHasValue = Ar.IsSaving() ? (IsQuantized() && bInRange ? Quantized != 0 : Value != 0.f) : 0;
+		Ar.SerializeBits(&bHasValue, 1);
+
+		if (!bHasValue)
+		{
+			if (Ar.IsLoading())
+			{
+				Value = 0.f;
+			}
+			return;
+		}
+
+		if (IsQuantized())
+		{
+			Ar.SerializeBits(&bInRange, 1);
+		}
+
+		if (IsQuantized() && bInRange)
+		{
+			Ar.SerializeInt(Quantized, GetMaxQuantized() + 1);
+			if (Ar.IsLoading())
+			{
+				Value = Dequantize(Quantized);
+			}
+		}
+		else
+		{
+			Ar << Value;
+		}
+	}
+
+	/** Serializes Value as a signed difference of DeltaBits quantization steps from BaseValue (which the reading side
+	 * must already know), falling back to SerializeOptional when the difference does not fit or Value is out of range.
+	 * Costs 1 + DeltaBits bits in the common case. */
+	void SerializeDelta(FArchive& Ar, float& Value, float BaseValue, uint8 DeltaBits) const
+	{
+		if (!IsQuantized() || DeltaBits == 0)
+		{
+			SerializeOptional(Ar, Value);
+			return;
+		}
+
+		const int64 MaxDelta = (int64(1) << (DeltaBits - 1)) - 1;
+		const int64 BaseQuantized = Quantize(BaseValue);
+		const int64 Delta = Ar.IsSaving() ? int64(Quantize(Value)) - BaseQuantized : 0;
+
+		// Out of range values can't be expressed in steps, SerializeOptional sends them raw
+		uint8 bIsDelta = Ar.IsSaving() ? IsInRange(Value) && FMath::Abs(Delta) <= MaxDelta : 0;
+		Ar.SerializeBits(&bIsDelta, 1);
+
+		if (!bIsDelta)
+		{
+			SerializeOptional(Ar, Value);
+			return;
+		}
+
+		// zigzag encoding so small negative deltas stay small
+		uint32 ZigZagDelta = Ar.IsSaving() ? static_cast<uint32>(Delta >= 0 ? Delta * 2 : -Delta * 2 - 1) : 0;
+		Ar.SerializeInt(ZigZagDelta, 1u << DeltaBits);
+		if (Ar.IsLoading())
+		{
+			const int64 LoadedDelta = (ZigZagDelta & 1) ? -int64(ZigZagDelta >> 1) - 1 : int64(ZigZagDelta >> 1);
+			Value = Dequantize(static_cast<uint32>(FMath::Clamp<int64>(BaseQuantized + LoadedDelta, 0, GetMaxQuantized())));
+		}
+	}
+
+	/** Smallest number of bits (at least MinNumBits) that keeps the quantization error of [0, InMaxValue] strictly
+	 * below MaxError. Returns 0 (raw float) if MinNumBits is 0 */
+	static uint8 GetRequiredBits(float InMaxValue, float MaxError, uint8 MinNumBits)
+	{
+		if (MinNumBits == 0)
+		{
+			return 0;
+		}
+
+		uint8 Bits = FMath::Min(MinNumBits, MaxNumBits);
+		if (InMaxValue <= 0.f)
+		{
+			return Bits;
+		}
+		if (MaxError <= 0.f)
+		{
+			return 0;
+		}
+
+		// error is half a step: InMaxValue / (2^Bits - 1) / 2 < MaxError
+		while (Bits < MaxNumBits && double((1u << Bits) - 1) * 2.0 * MaxError <= InMaxValue)
+		{
+			++Bits;
+		}
+		return Bits;
+	}
+};
+
+/**
+ * TXMUQuantizedPolarVector
+ *
+ *	Packs a vector as the direction and length of its XY component plus its Z component, each on its own number of
+ *	bits. Length is mapped onto [0, MaxValue] and Z onto [-MaxValue, MaxValue] with round-to-nearest. The direction
+ *	wraps around, so it uses every one of its 2^AngleBits steps and any angle CartesianToPolar returns ([-PI, PI])
+ *	lands on the nearest step.
+ */
+template<uint8 AngleBits, uint8 MagnitudeBits, uint8 ZBits>
+struct TXMUQuantizedPolarVector
+{
+	static_assert(AngleBits > 0 && AngleBits <= 16, "AngleBits must be in [1, 16]");
+	static_assert(MagnitudeBits > 0 && MagnitudeBits <= 16, "MagnitudeBits must be in [1, 16]");
+	static_assert(ZBits > 1 && ZBits <= 16, "ZBits must be in [2, 16]");
+
+	static constexpr uint32 AngleSteps = 1u << AngleBits;
+	static constexpr uint32 MaxMagnitude = (1u << MagnitudeBits) - 1;
+	/** Z is symmetric around 0, so the most negative value of its signed range is unused */
+	static constexpr int32 MaxZ = (1 << (ZBits - 1)) - 1;
+
+	uint16 Angle = 0;
+	uint16 Magnitude = 0;
+	int16 Z = 0;
+
+	void Quantize(const FVector& Vector, double MaxValue)
+	{
+		if (MaxValue <= 0.0)
+		{
+			*this = TXMUQuantizedPolarVector();
+			return;
+		}
+		
+		double XYMagnitude, XYRadians;
+		FMath::CartesianToPolar(Vector.X, Vector.Y, XYMagnitude, XYRadians);
+
+		Magnitude = static_cast<uint16>(FMath::Clamp<int64>(FMath::RoundToInt64(XYMagnitude / MaxValue * MaxMagnitude), 0, MaxMagnitude));
+		// Masking wraps both negative angles and +PI (which rounds to AngleSteps) back into [0, AngleSteps)
+		Angle = Magnitude == 0 ? 0 : static_cast<uint16>(FMath::RoundToInt64(XYRadians / UE_DOUBLE_TWO_PI * AngleSteps) & (AngleSteps - 1));
+		Z = static_cast<int16>(FMath::Clamp<int64>(FMath::RoundToInt64(Vector.Z / MaxValue * MaxZ), -MaxZ, MaxZ));
+	}
+
+	FVector Dequantize(double MaxValue) const
+	{
+		FVector Vector(FVector::ZeroVector);
+		const double XYMagnitude = double(FMath::Min<uint32>(Magnitude, MaxMagnitude)) * MaxValue / MaxMagnitude;
+		const double XYRadians = double(Angle & (AngleSteps - 1)) * UE_DOUBLE_TWO_PI / AngleSteps;
+		FMath::PolarToCartesian(XYMagnitude, XYRadians, Vector.X, Vector.Y);
+		Vector.Z = double(FMath::Clamp<int32>(Z, -MaxZ, MaxZ)) * MaxValue / MaxZ;
+		return Vector;
+	}
+
+	/** Largest errors introduced by Quantize / Dequantize, for each component (radians, length, z) */
+	static constexpr double GetMaxAngleError() { return UE_DOUBLE_PI / AngleSteps; }
+	static double GetMaxMagnitudeError(double MaxValue) { return 0.5 * MaxValue / MaxMagnitude; }
+	static double GetMaxZError(double MaxValue) { return 0.5 * MaxValue / MaxZ; }
+
+	bool operator==(const TXMUQuantizedPolarVector& Other) const
+	{
+		return Angle == Other.Angle && Magnitude == Other.Magnitude && Z == Other.Z;
+	}
+	bool operator!=(const TXMUQuantizedPolarVector& Other) const { return !(*this == Other); }
+};
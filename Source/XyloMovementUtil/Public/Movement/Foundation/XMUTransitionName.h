@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "XMUTransitionName.generated.h"
+
+/**
+ * FXMUTransitionNameRegistry
+ *
+ *	Interns root motion transition names into compact ids. Id 0 is always NAME_None.
+ *	Ids are handed out in registration order, so names that are replicated as ids must be registered in the same order
+ *	on server and clients (e.g. from a module StartupModule or GameInstance Init) before being used.
+ *	Game thread only.
+ */
+class XYLOMOVEMENTUTIL_API FXMUTransitionNameRegistry
+{
+public:
+	static FXMUTransitionNameRegistry& Get();
+
+	/** Returns the id of InName, registering it if needed */
+	uint16 FindOrAdd(FName InName);
+	/** Returns the id of InName, or 0 if it was never registered */
+	uint16 Find(FName InName) const;
+	FName GetName(uint16 Id) const;
+	int32 Num() const { return Names.Num(); }
+
+private:
+	FXMUTransitionNameRegistry();
+
+	TArray<FName> Names;
+	TMap<FName, uint16> NameToId;
+};
+
+/**
+ * FXMUTransitionName
+ *
+ *	Interned transition name: copies and compares are integer operations, and it replicates as its id.
+ */
+USTRUCT(BlueprintType)
+struct XYLOMOVEMENTUTIL_API FXMUTransitionName
+{
+	GENERATED_BODY()
+
+	FXMUTransitionName()
+		: Id(0)
+	{}
+
+	/** Registers InName if needed */
+	FXMUTransitionName(FName InName)
+		: Id(FXMUTransitionNameRegistry::Get().FindOrAdd(InName))
+	{}
+
+	bool IsNone() const { return Id == 0; }
+	uint16 GetId() const { return Id; }
+	FName GetName() const { return FXMUTransitionNameRegistry::Get().GetName(Id); }
+	FString ToString() const { return IsNone() ? FString() : GetName().ToString(); }
+	void Reset() { Id = 0; }
+
+	bool operator==(const FXMUTransitionName& Other) const { return Id == Other.Id; }
+	bool operator!=(const FXMUTransitionName& Other) const { return Id != Other.Id; }
+	friend uint32 GetTypeHash(const FXMUTransitionName& TransitionName) { return TransitionName.Id; }
+
+	/** Sends the id packed (a single byte for the first 128 registered names) */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+private:
+	UPROPERTY()
+	uint16 Id;
+};
+
+template<>
+struct TStructOpsTypeTraits<FXMUTransitionName> : public TStructOpsTypeTraitsBase2<FXMUTransitionName>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true,
+	};
+};
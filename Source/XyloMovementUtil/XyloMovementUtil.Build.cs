@@ -36,6 +36,7 @@ public class XyloMovementUtil : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"NetCore",
 				"Slate",
 				"SlateCore",
 				"EnhancedInput",